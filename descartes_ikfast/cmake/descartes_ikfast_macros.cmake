@@ -0,0 +1,39 @@
+#
+# @file descartes_ikfast_macros.cmake
+# @brief CMake functions for building IKFast solvers
+#
+# @par License
+# Software License Agreement (Apache License)
+# @par
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+# http://www.apache.org/licenses/LICENSE-2.0
+# @par
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+
+# Writes a copy of an IKFast generated solver that can be compiled in single precision, see the descartes_ikfast_float
+# target. The generated code rejects candidate solutions whose residuals exceed hard coded 1e-6 thresholds, which float
+# arithmetic routinely misses; those thresholds are replaced by IKFAST_EVALCOND_THRESH (1e-6 unless defined).
+# Usage: descartes_ikfast_float_solver(<input> <output>)
+function(descartes_ikfast_float_solver input output)
+  get_filename_component(input "${input}" ABSOLUTE)
+  file(READ "${input}" contents)
+
+  set(residual_check "(IKabs\\((evalcond|dummyeval)\\[[0-9]+\\]\\) [<>] )")
+  string(REGEX REPLACE "${residual_check}0\\.0000010000000000" "\\1IKFAST_EVALCOND_THRESH" contents "${contents}")
+  string(REGEX REPLACE "${residual_check}0\\.000001" "\\1IKFAST_EVALCOND_THRESH" contents "${contents}")
+
+  file(WRITE "${output}"
+    "// Generated by descartes_ikfast_float_solver() from ${input}\n"
+    "#ifndef IKFAST_EVALCOND_THRESH\n"
+    "#define IKFAST_EVALCOND_THRESH ((IkReal)0.000001)\n"
+    "#endif\n"
+    "${contents}")
+  set_property(DIRECTORY APPEND PROPERTY CMAKE_CONFIGURE_DEPENDS "${input}")
+endfunction()
@@ -40,6 +40,12 @@ public:
   bool ik(const Eigen::Transform<FloatType, 3, Eigen::Isometry>& p,
           std::vector<FloatType>& solution_set) const override;
 
+  /** @brief Batched IK; the base and tool transforms are inverted once for the whole batch */
+  bool ik(const Eigen::Transform<FloatType, 3, Eigen::Isometry>* poses,
+          const std::size_t n,
+          std::vector<FloatType>& solution_set,
+          std::vector<std::size_t>& offsets) const override;
+
   bool fk(const FloatType* pose, Eigen::Transform<FloatType, 3, Eigen::Isometry>& solution) const override;
 
   int dof() const override;
@@ -56,6 +62,12 @@ protected:
           const IsValidFn<FloatType>& is_valid_fn,
           const GetRedundantSolutionsFn<FloatType>& redundant_sol_fn,
           std::vector<FloatType>& solution_set) const;
+
+  /** @brief Solves IK for a pose of the tip given in the robot base frame */
+  bool ikInBase(const Eigen::Transform<FloatType, 3, Eigen::Isometry>& in_robot,
+                const IsValidFn<FloatType>& is_valid_fn,
+                const GetRedundantSolutionsFn<FloatType>& redundant_sol_fn,
+                std::vector<FloatType>& solution_set) const;
 };
 
 using IKFastKinematicsD = IKFastKinematics<double>;
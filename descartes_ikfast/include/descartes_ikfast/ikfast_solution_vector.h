@@ -0,0 +1,72 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2016, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef DESCARTES_IKFAST_IKFAST_SOLUTION_VECTOR_H
+#define DESCARTES_IKFAST_IKFAST_SOLUTION_VECTOR_H
+
+#include <descartes_ikfast/external/ikfast.h>
+#include <stdexcept>
+#include <vector>
+
+namespace descartes_light
+{
+/**
+ * @brief A vector backed replacement for ikfast::IkSolutionList
+ *
+ * GetSolution() is constant time instead of walking a std::list. Clear() keeps the solutions, and the storage of their
+ * joint values, for reuse by the next AddSolution() calls, so a list that is reused across IK calls stops allocating
+ * once it has seen the largest number of solutions per pose.
+ */
+template <typename T>
+class IkSolutionVector : public ikfast::IkSolutionListBase<T>
+{
+public:
+  size_t AddSolution(const std::vector<ikfast::IkSingleDOFSolutionBase<T>>& vinfos,
+                     const std::vector<int>& vfree) override
+  {
+    if (size_ < solutions_.size())
+    {
+      // Copy assignment reuses the capacity of the recycled solution
+      solutions_[size_]._vbasesol = vinfos;
+      solutions_[size_]._vfree = vfree;
+    }
+    else
+    {
+      solutions_.emplace_back(vinfos, vfree);
+    }
+    return size_++;
+  }
+
+  const ikfast::IkSolutionBase<T>& GetSolution(size_t index) const override
+  {
+    if (index >= size_)
+      throw std::runtime_error("GetSolution index is invalid");
+
+    return solutions_[index];
+  }
+
+  size_t GetNumSolutions() const override { return size_; }
+
+  void Clear() override { size_ = 0; }
+
+private:
+  std::vector<ikfast::IkSolution<T>> solutions_;
+  size_t size_ = 0;
+};
+
+}  // namespace descartes_light
+#endif  // DESCARTES_IKFAST_IKFAST_SOLUTION_VECTOR_H
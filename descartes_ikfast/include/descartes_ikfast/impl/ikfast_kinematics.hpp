@@ -21,6 +21,7 @@
 #define IKFAST_HAS_LIBRARY
 #define IKFAST_NO_MAIN
 #include <descartes_ikfast/external/ikfast.h>
+#include <descartes_ikfast/ikfast_solution_vector.h>
 #include <descartes_ikfast/ikfast_kinematics.h>
 #include <descartes_light/utils.h>
 #include <console_bridge/console.h>
@@ -47,14 +48,46 @@ bool IKFastKinematics<FloatType>::ik(const Eigen::Transform<FloatType, 3, Eigen:
   return IKFastKinematics<FloatType>::ik(p, is_valid_fn_, redundant_sol_fn_, solution_set);
 }
 
+template <typename FloatType>
+bool IKFastKinematics<FloatType>::ik(const Eigen::Transform<FloatType, 3, Eigen::Isometry>* poses,
+                                     const std::size_t n,
+                                     std::vector<FloatType>& solution_set,
+                                     std::vector<std::size_t>& offsets) const
+{
+  const Eigen::Transform<FloatType, 3, Eigen::Isometry> base_inv = world_to_robot_base_.inverse();
+  const Eigen::Transform<FloatType, 3, Eigen::Isometry> tool_inv = tool0_to_tip_.inverse();
+
+  offsets.resize(n + 1);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    offsets[i] = solution_set.size();
+    ikInBase(base_inv * poses[i] * tool_inv, is_valid_fn_, redundant_sol_fn_, solution_set);
+  }
+  offsets[n] = solution_set.size();
+
+  return offsets[n] != offsets[0];
+}
+
 template <typename FloatType>
 bool IKFastKinematics<FloatType>::ik(const Eigen::Transform<FloatType, 3, Eigen::Isometry>& p,
                                      const IsValidFn<FloatType>& is_valid_fn,
                                      const GetRedundantSolutionsFn<FloatType>& redundant_sol_fn,
                                      std::vector<FloatType>& solution_set) const
 {
-  const Eigen::Transform<FloatType, 3, Eigen::Isometry> in_robot =
-      world_to_robot_base_.inverse() * p * tool0_to_tip_.inverse();
+  return ikInBase(
+      world_to_robot_base_.inverse() * p * tool0_to_tip_.inverse(), is_valid_fn, redundant_sol_fn, solution_set);
+}
+
+template <typename FloatType>
+bool IKFastKinematics<FloatType>::ikInBase(const Eigen::Transform<FloatType, 3, Eigen::Isometry>& in_robot,
+                                           const IsValidFn<FloatType>& is_valid_fn,
+                                           const GetRedundantSolutionsFn<FloatType>& redundant_sol_fn,
+                                           std::vector<FloatType>& solution_set) const
+{
+  // Reused by every call on this thread, so that solving does not allocate once these have grown to their working size
+  thread_local IkSolutionVector<IkReal> ikfast_solution_set;
+  thread_local std::vector<IkReal> ikfast_sol;
+  thread_local std::vector<FloatType> sol;
 
   // Convert to ikfast data type
   Eigen::Transform<IkReal, 3, Eigen::Isometry> ikfast_tcp = in_robot.template cast<IkReal>();
@@ -66,85 +99,38 @@ bool IKFastKinematics<FloatType>::ik(const Eigen::Transform<FloatType, 3, Eigen:
   // ordering
   const Eigen::Matrix<IkReal, 3, 3, Eigen::RowMajor> rotation = ikfast_tcp.rotation();
 
-  // Call IK (TODO: Make a better solution list class? One that uses vector instead of list)
-  ikfast::IkSolutionList<IkReal> ikfast_solution_set;
+  // Call IK
   ComputeIk(translation.data(), rotation.data(), nullptr, ikfast_solution_set);
 
-  // Unpack the solutions into the output vector
-  const auto n_sols = ikfast_solution_set.GetNumSolutions();
-  int ikfast_dof = dof();
-
-  std::vector<IkReal> ikfast_output;
-  ikfast_output.resize(n_sols * ikfast_dof);
+  // Unpack and check the solutions in a single pass over the solution list
+  const int ikfast_dof = dof();
+  const std::size_t n_dof = static_cast<std::size_t>(ikfast_dof);
+  ikfast_sol.resize(n_dof);
+  sol.resize(n_dof);
 
+  const std::size_t n_sols = ikfast_solution_set.GetNumSolutions();
   for (std::size_t i = 0; i < n_sols; ++i)
   {
-    // This actually walks the list EVERY time from the start of i.
-    const auto& sol = ikfast_solution_set.GetSolution(i);
-    auto* out = ikfast_output.data() + i * ikfast_dof;
-    sol.GetSolution(out, nullptr);
-  }
+    ikfast_solution_set.GetSolution(i).GetSolution(ikfast_sol.data(), nullptr);
+    for (std::size_t j = 0; j < n_dof; ++j)
+      sol[j] = static_cast<FloatType>(ikfast_sol[j]);
 
-  std::vector<FloatType> sols;
-  sols.insert(end(sols), ikfast_output.begin(), ikfast_output.end());
+    if (!isValid<FloatType>(sol.data(), ikfast_dof))
+      continue;
 
-  // Check the output
-  int num_sol = sols.size() / ikfast_dof;
-  for (int i = 0; i < num_sol; i++)
-  {
-    FloatType* sol = sols.data() + ikfast_dof * i;
-    if (isValid<FloatType>(sol, ikfast_dof))
-    {
-      harmonizeTowardZero<FloatType>(sol, ikfast_dof);  // Modifies 'sol' in place
+    harmonizeTowardZero<FloatType>(sol.data(), ikfast_dof);  // Modifies 'sol' in place
 
-      std::vector<FloatType> full_sol;
-      full_sol.insert(end(full_sol), sol, sol + ikfast_dof);  // And then insert the robot arm configuration
+    if (!is_valid_fn || is_valid_fn(sol.data()))
+      solution_set.insert(end(solution_set), sol.begin(), sol.end());  // If good then add to solution set
 
-      if (is_valid_fn && redundant_sol_fn)
-      {
-        if (is_valid_fn(full_sol.data()))
-          solution_set.insert(end(solution_set), full_sol.data(), full_sol.data() + ikfast_dof);  // If good then add to
-                                                                                                  // solution set
-
-        std::vector<FloatType> redundant_sols = redundant_sol_fn(full_sol.data());
-        if (!redundant_sols.empty())
-        {
-          int num_sol = redundant_sols.size() / ikfast_dof;
-          for (int s = 0; s < num_sol; ++s)
-          {
-            FloatType* redundant_sol = redundant_sols.data() + ikfast_dof * s;
-            if (is_valid_fn(redundant_sol))
-              solution_set.insert(end(solution_set), redundant_sol, redundant_sol + ikfast_dof);  // If good then add to
-                                                                                                  // solution set
-          }
-        }
-      }
-      else if (is_valid_fn && !redundant_sol_fn)
-      {
-        if (is_valid_fn(full_sol.data()))
-          solution_set.insert(end(solution_set), full_sol.data(), full_sol.data() + ikfast_dof);  // If good then add to
-                                                                                                  // solution set
-      }
-      else if (!is_valid_fn && redundant_sol_fn)
-      {
-        solution_set.insert(end(solution_set), full_sol.data(), full_sol.data() + ikfast_dof);  // If good then add to
-                                                                                                // solution set
-
-        std::vector<FloatType> redundant_sols = redundant_sol_fn(full_sol.data());
-        if (!redundant_sols.empty())
-        {
-          int num_sol = redundant_sols.size() / ikfast_dof;
-          for (int s = 0; s < num_sol; ++s)
-          {
-            FloatType* redundant_sol = redundant_sols.data() + ikfast_dof * s;
-            solution_set.insert(end(solution_set), redundant_sol, redundant_sol + ikfast_dof);  // If good then add to
-                                                                                                // solution set
-          }
-        }
-      }
-      else
+    if (redundant_sol_fn)
+    {
+      const std::vector<FloatType> redundant_sols = redundant_sol_fn(sol.data());
+      for (std::size_t s = 0; s + n_dof <= redundant_sols.size(); s += n_dof)
       {
-        solution_set.insert(end(solution_set), full_sol.data(), full_sol.data() + ikfast_dof);
+        const FloatType* redundant_sol = redundant_sols.data() + s;
+        if (!is_valid_fn || is_valid_fn(redundant_sol))
+          solution_set.insert(end(solution_set), redundant_sol, redundant_sol + n_dof);
       }
     }
   }
@@ -0,0 +1,140 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2016, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+#include <descartes_ikfast_fanuc_m20ia10l_manipulator.h>
+
+// Solves IK for poses generated by fk from random joint values, and checks the fk error of every solution and how often
+// the generating joint values are recovered. Built once against the double precision solver and, with
+// DESCARTES_IKFAST_SINGLE_PRECISION, once against the single precision one.
+
+namespace
+{
+/** @brief The bounds a solver meets with the precision of IkReal and FloatType */
+struct Bounds
+{
+  double position;  /** @brief The largest fk error of a solution, in m */
+  double rotation;  /** @brief The largest fk error of a solution, in rad */
+  double missed;    /** @brief The largest fraction of poses whose generating joint values are not recovered */
+};
+
+template <typename FloatType>
+Bounds bounds()
+{
+  // The errors measured on 20000 poses are 5e-10 m in double precision, 4e-7 m with double IkReal and float FloatType
+  // and 5e-5 m with float IkReal; the bounds leave an order of magnitude of margin
+  if (sizeof(IkReal) < sizeof(double))
+    return Bounds{ 5e-4, 5e-4, 0.01 };
+  if (sizeof(FloatType) < sizeof(double))
+    return Bounds{ 5e-6, 2e-5, 0.02 };
+  return Bounds{ 1e-8, 1e-8, 1e-3 };
+}
+
+template <typename FloatType>
+void checkPrecision(const std::size_t n_poses)
+{
+  using Transform = Eigen::Transform<FloatType, 3, Eigen::Isometry>;
+  const Transform identity = Transform::Identity();
+  descartes_ikfast_unit::FanucM20ia10lKinematics<FloatType> robot(identity, identity, nullptr, nullptr);
+  const Bounds bound = bounds<FloatType>();
+
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<double> joint(-2.5, 2.5);
+
+  std::vector<std::array<FloatType, 6>> seeds(n_poses);
+  std::vector<Transform, Eigen::aligned_allocator<Transform>> poses(n_poses);
+  for (std::size_t i = 0; i < n_poses; ++i)
+  {
+    for (FloatType& q : seeds[i])
+      q = static_cast<FloatType>(joint(rng));
+    ASSERT_TRUE(robot.fk(seeds[i].data(), poses[i]));
+  }
+
+  std::size_t n_sols = 0;
+  std::size_t seed_missed = 0;
+  double max_position_error = 0;
+  double max_rotation_error = 0;
+  std::vector<FloatType> solution_set;
+  for (std::size_t i = 0; i < n_poses; ++i)
+  {
+    solution_set.clear();
+    robot.ik(poses[i], solution_set);
+
+    double seed_error = std::numeric_limits<double>::max();
+    for (std::size_t s = 0; s < solution_set.size(); s += 6, ++n_sols)
+    {
+      double error = 0;
+      for (std::size_t j = 0; j < 6; ++j)
+        error = std::max(error, std::abs(std::remainder(double(solution_set[s + j] - seeds[i][j]), 2 * M_PI)));
+      seed_error = std::min(seed_error, error);
+
+      Transform pose;
+      EXPECT_TRUE(robot.fk(solution_set.data() + s, pose));
+      const double position_error = double((pose.translation() - poses[i].translation()).norm());
+      const double rotation_error =
+          double(Eigen::AngleAxis<FloatType>(pose.linear().transpose() * poses[i].linear()).angle());
+      max_position_error = std::max(max_position_error, position_error);
+      max_rotation_error = std::max(max_rotation_error, rotation_error);
+    }
+
+    if (seed_error > 1e-2)
+      ++seed_missed;
+  }
+
+  EXPECT_GT(n_sols, n_poses);
+  EXPECT_LE(max_position_error, bound.position);
+  EXPECT_LE(max_rotation_error, bound.rotation);
+  EXPECT_LE(double(seed_missed), bound.missed * double(n_poses));
+
+  // Report the throughput, to compare the precisions of the solver
+  const auto start = std::chrono::steady_clock::now();
+  for (const Transform& pose : poses)
+  {
+    solution_set.clear();
+    robot.ik(pose, solution_set);
+  }
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::printf("IkReal %zu bytes, FloatType %zu bytes: %.0f ns per ik, %.2f solutions per pose, generating joints "
+              "missed for %zu of %zu poses, max fk error of a solution %.2e m, %.2e rad\n",
+              sizeof(IkReal),
+              sizeof(FloatType),
+              1e9 * seconds / double(n_poses),
+              double(n_sols) / double(n_poses),
+              seed_missed,
+              n_poses,
+              max_position_error,
+              max_rotation_error);
+}
+}  // namespace
+
+TEST(DescartesIkFastPrecisionUnit, Double) { checkPrecision<double>(20000); }
+
+TEST(DescartesIkFastPrecisionUnit, Float) { checkPrecision<float>(20000); }
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,152 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2016, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef DESCARTES_LIGHT_ARENA_H
+#define DESCARTES_LIGHT_ARENA_H
+
+#include <descartes_light/visibility_control.h>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace descartes_light
+{
+/**
+ * @brief A monotonic memory arena: allocation bumps a pointer within large blocks and deallocation does nothing
+ *
+ * reset() makes all of the memory available again without returning the blocks to the heap, so a structure that is
+ * torn down and rebuilt in the arena stops calling malloc once the arena has grown to its working size.
+ *
+ * An arena is not thread safe; give each thread its own.
+ */
+class DESCARTES_PUBLIC MonotonicArena
+{
+public:
+  /** @param block_size The size of the blocks requested from the heap, larger allocations get a block of their own */
+  explicit MonotonicArena(const std::size_t block_size = 1 << 20);
+
+  MonotonicArena(const MonotonicArena&) = delete;
+  MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+  /** @param alignment A power of two, at most alignof(std::max_align_t) */
+  void* allocate(const std::size_t bytes, const std::size_t alignment);
+
+  /** @brief Makes all of the memory available again. Everything allocated before is invalidated. */
+  void reset() noexcept;
+
+  /** @brief Returns all blocks to the heap. Everything allocated before is invalidated. */
+  void release() noexcept;
+
+  /** @brief The total size of the blocks held */
+  std::size_t capacity() const noexcept;
+
+  /** @brief The arena of the calling thread set by ArenaScope, or nullptr */
+  static MonotonicArena* current() noexcept;
+
+private:
+  struct Block
+  {
+    std::unique_ptr<char[]> data;
+    std::size_t size;
+  };
+
+  std::size_t block_size_;
+  std::vector<Block> blocks_;
+  std::size_t block_;   /** @brief The block allocations are taken from */
+  std::size_t offset_;  /** @brief The first free byte in that block */
+};
+
+/**
+ * @brief Makes an arena the current arena of the calling thread for the lifetime of the scope, see ArenaAllocator
+ */
+class DESCARTES_PUBLIC ArenaScope
+{
+public:
+  /** @param arena The arena, or nullptr to allocate from the heap within the scope */
+  explicit ArenaScope(MonotonicArena* arena) noexcept;
+  ~ArenaScope();
+
+  ArenaScope(const ArenaScope&) = delete;
+  ArenaScope& operator=(const ArenaScope&) = delete;
+
+private:
+  MonotonicArena* previous_;
+};
+
+/**
+ * @brief A standard allocator drawing from a MonotonicArena, or from the heap if it has none
+ *
+ * A default constructed allocator takes the current arena of the calling thread, so containers created within an
+ * ArenaScope (e.g. by resize() of an outer container) allocate from that arena without being told so. The allocator
+ * moves and swaps along with the memory of its container. Copies of a container take the current arena, never the one
+ * of the original.
+ */
+template <typename T>
+class ArenaAllocator
+{
+public:
+  using value_type = T;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+
+  ArenaAllocator() noexcept : arena_(MonotonicArena::current()) {}
+  explicit ArenaAllocator(MonotonicArena* arena) noexcept : arena_(arena) {}
+
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena_(other.arena())
+  {
+  }
+
+  T* allocate(std::size_t n)
+  {
+    if (arena_ == nullptr)
+      return static_cast<T*>(::operator new(n * sizeof(T)));
+
+    return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T* p, std::size_t) noexcept
+  {
+    if (arena_ == nullptr)
+      ::operator delete(p);
+  }
+
+  ArenaAllocator select_on_container_copy_construction() const noexcept { return ArenaAllocator(); }
+
+  MonotonicArena* arena() const noexcept { return arena_; }
+
+private:
+  MonotonicArena* arena_;
+};
+
+template <typename T, typename U>
+inline bool operator==(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) noexcept
+{
+  return lhs.arena() == rhs.arena();
+}
+
+template <typename T, typename U>
+inline bool operator!=(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) noexcept
+{
+  return lhs.arena() != rhs.arena();
+}
+
+}  // namespace descartes_light
+
+#endif  // DESCARTES_LIGHT_ARENA_H
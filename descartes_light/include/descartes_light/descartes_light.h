@@ -22,7 +22,11 @@
 #include "descartes_light/ladder_graph.h"
 #include "descartes_light/interface/position_sampler.h"
 #include "descartes_light/interface/edge_evaluator.h"
+#include "descartes_light/thread_clones.h"
 #include <omp.h>
+#include <set>
+#include <tuple>
+#include <utility>
 #include <vector>
 
 namespace descartes_light
@@ -33,6 +37,81 @@ class Solver
 public:
   Solver(const std::size_t dof);
 
+  /**
+   * @brief Lets the solver bypass waypoints that cannot be reached instead of failing the whole plan
+   *
+   * When build() finds unreachable waypoints or rungs without edges, it adds skip edges around each break that bypass
+   * up to 'max_skipped_rungs' consecutive rungs. Each bypassed rung adds 'skip_penalty' to the cost of the path, so
+   * with a penalty larger than any regular path cost the search returns the path visiting the most waypoints.
+   *
+   * @param max_skipped_rungs The maximum number of consecutive rungs a single skip edge bypasses, zero disables skipping
+   * @param skip_penalty The cost added per bypassed rung
+   */
+  void setSkipping(const std::size_t max_skipped_rungs, const FloatType skip_penalty);
+
+  /**
+   * @brief Allocates the edges of the graph from per-thread monotonic arenas instead of the heap, see
+   * LadderGraph::setUseArena(). Rebuilding and destroying large graphs then no longer goes through malloc and free.
+   */
+  void setUseArena(const bool use_arena);
+
+  /**
+   * @brief Gives every thread of build() its own clones of the collision interfaces, kinematics and edge evaluator,
+   * see ThreadClones. Enabled by default.
+   *
+   * The samplers and the edge evaluator are then free to use stateful collision checkers without locking. Each
+   * instance is cloned once per thread, on its first use, and the clones are kept for later builds while the instance
+   * lives. The searches run on the calling thread and use the instances themselves.
+   */
+  void setUseThreadClones(const bool use_thread_clones);
+
+  /**
+   * @brief Defers the evaluation of edges from build() to search()
+   *
+   * build() then only samples the vertices. search() runs a best-first search (see DAGSearch::runLazy()) that evaluates
+   * the out edges of a vertex the first time it is expanded and keeps them for later searches. Vertices that cost more
+   * to reach than the solution are never expanded, so their edges are never evaluated. This saves the most when
+   * search() is given initial costs, see getStartCosts(): the IK branches far from the start state are then never
+   * expanded. Without them, all branches progress alike and most edges end up evaluated, on a single thread.
+   *
+   * A 'block_size' above one evaluates the out edges of that many consecutive vertices at once. The samplers store the
+   * IK branches of a pose next to each other, so blocks mostly evaluate edges of branches the search does not need.
+   * The edge evaluator must not return negative costs.
+   *
+   * Has no effect while skipping is enabled, as locating the breaks needs every edge. Since build() evaluates no edges,
+   * it no longer reports failed edges; search() fails instead.
+   */
+  void setLazyEdges(const bool lazy_edges, const std::size_t block_size = 1);
+
+  /**
+   * @brief Defers the collision checks of the samplers from build() to search()
+   *
+   * build() then inserts the solutions of PositionSampler::sampleUnchecked() as vertices. search() checks only the
+   * vertices of the path it finds, with PositionSampler::isValid(), removes those in collision from the graph and
+   * searches again, until the path found is free of collision or no path is left. Vertices are checked at most once,
+   * so repeated searches reuse the results. Most vertices are never on a candidate path and never checked, see
+   * getSavedCollisionChecks().
+   *
+   * The skip edges of setSkipping() only bypass the waypoints that failed to sample, not rungs that run out of valid
+   * vertices during the search.
+   *
+   * Edge evaluators that defer checks of their own, see EdgeEvaluator::hasDeferredChecks(), are handled the same way
+   * whether or not this is enabled: search() checks the edges of the path found, once its vertices are valid, and
+   * removes the edges that fail.
+   */
+  void setLazyCollisionChecking(const bool lazy_collision);
+
+  /**
+   * @brief The number of vertices inserted by build() with setLazyCollisionChecking() that no search has checked for
+   * collision yet, each a check saved. Zero without lazy collision checking.
+   */
+  std::size_t getSavedCollisionChecks() const;
+
+  /**
+   * @brief Builds the graph
+   * @return True if every waypoint was sampled and every pair of rungs is connected. With skipping enabled, also true
+   * if every break is spanned by skip edges; search() then reports whether a path actually exists.
+   */
   bool build(const std::vector<typename PositionSampler<FloatType>::Ptr>& trajectory,
              const std::vector<descartes_core::TimingConstraint<FloatType>>& times,
              typename EdgeEvaluator<FloatType>::Ptr edge_eval,
@@ -41,14 +120,150 @@ public:
   const std::vector<std::size_t>& getFailedVertices() const { return failed_vertices_; }
   const std::vector<std::size_t>& getFailedEdges() const { return failed_edges_; }
 
+  /** @brief The rungs left out of the last solution because skip edges bypassed them, see setSkipping() */
+  const std::vector<std::size_t>& getSkippedRungs() const { return skipped_rungs_; }
+
   bool search(std::vector<FloatType>& solution);
 
+  /**
+   * @brief Searches the graph built by build() with constraints on where the path may start and end
+   *
+   * Replanning from a new start state only requires new initial costs, see getStartCosts(), not a new build().
+   *
+   * @param solution The joint values of the path, one vertex per rung
+   * @param initial_costs One cost per vertex of the first rung, or empty for zero costs
+   * @param terminal_costs One cost per vertex of the last rung, or empty for zero costs
+   * @return True if a path was found, otherwise false
+   */
+  bool search(std::vector<FloatType>& solution,
+              const std::vector<FloatType>& initial_costs,
+              const std::vector<FloatType>& terminal_costs);
+
+  /**
+   * @brief Computes the cost of moving from a seed joint state to each vertex of the first rung, using the edge
+   * evaluator given to build(). Vertices the evaluator does not connect get std::numeric_limits<FloatType>::max().
+   * @param start_state The seed joint state, 'dof' values
+   * @return The initial costs to pass to search(), or empty if the graph has not been built
+   */
+  std::vector<FloatType> getStartCosts(const std::vector<FloatType>& start_state) const;
+
+  /**
+   * @brief Computes the cost of moving from each vertex of the last rung to a goal joint state, using the edge
+   * evaluator given to build(). The goal has no timing constraint.
+   * @param goal_state The goal joint state, 'dof' values
+   * @return The terminal costs to pass to search(), or empty if the graph has not been built
+   */
+  std::vector<FloatType> getGoalCosts(const std::vector<FloatType>& goal_state) const;
+
+  /**
+   * @brief Searches for a closed path that ends in a configuration connected back to the one it starts in
+   *
+   * The closing edges from the last rung back to the first rung are computed with the edge evaluator given to build().
+   * If the last waypoint repeats the first one, identical configurations close the loop at zero cost.
+   *
+   * The closing motion inherits the timing of the first rung. That timing is usually unconstrained, so any vertex of
+   * the last rung connects back to any vertex of the first rung and closing the loop is only preferred by its cost.
+   * Pass a closing timing to limit the closing motion instead.
+   *
+   * @param solution The joint values of the path, one vertex per rung. The closing motion is not repeated.
+   * @return True if a closed path was found, otherwise false
+   */
+  bool searchCyclic(std::vector<FloatType>& solution);
+
+  /**
+   * @brief Searches for a closed path whose closing motion, from the last rung back to the first rung, is evaluated
+   * with 'closing_timing' instead of the timing of the first rung
+   * @param solution The joint values of the path, one vertex per rung. The closing motion is not repeated.
+   * @param closing_timing The timing the edge evaluator applies to the closing motion
+   * @return True if a closed path was found, otherwise false
+   */
+  bool searchCyclic(std::vector<FloatType>& solution,
+                    const descartes_core::TimingConstraint<FloatType>& closing_timing);
+
+  /**
+   * @brief Diagnoses why search() fails without running it, by locating the rung windows where the ladder is broken.
+   * Evaluates the edges still deferred by setLazyEdges().
+   * @return The inclusive rung windows [first, last] in which no vertex of 'first' connects to any vertex of 'last'
+   */
+  std::vector<std::pair<std::size_t, std::size_t>> findDisconnections();
+
   static int getMaxThreads() { return omp_get_max_threads(); }
 
 private:
   LadderGraph<FloatType> graph_;
+  typename EdgeEvaluator<FloatType>::Ptr edge_eval_;
   std::vector<std::size_t> failed_vertices_;
   std::vector<std::size_t> failed_edges_;
+  std::vector<std::size_t> skipped_rungs_;
+  std::size_t max_skipped_rungs_;
+  FloatType skip_penalty_;
+  std::size_t vertex_capacity_hint_;  /** @brief The size of the largest rung of the last build */
+  bool lazy_edges_;
+  std::size_t lazy_block_size_;
+  bool edges_deferred_;                              /** @brief Whether the last build left the edges to search() */
+  std::vector<std::vector<char>> evaluated_blocks_;  /** @brief Per rung, which blocks of out edges are evaluated */
+  std::size_t n_evaluated_vertices_;                 /** @brief The vertices whose out edges are evaluated */
+  Rung_<FloatType> deferred_from_;                   /** @brief The block of vertices passed to the edge evaluator */
+  std::vector<typename LadderGraph<FloatType>::EdgeList> deferred_edges_;  /** @brief The out edges of that block */
+  bool lazy_collision_;
+  bool collision_deferred_;  /** @brief Whether the last build left the collision checks to search() */
+  std::vector<typename PositionSampler<FloatType>::Ptr> samplers_;  /** @brief The samplers of the rungs to check */
+  std::vector<std::vector<char>> vertex_states_;  /** @brief Per rung, whether each vertex is unchecked, valid or not */
+  std::size_t n_collision_checks_;
+  bool edge_checks_deferred_;  /** @brief Whether the edge evaluator of the last build leaves checks to search() */
+  /** @brief The edges (from rung, from index, to rung, to index) whose deferred checks passed */
+  std::set<std::tuple<std::size_t, unsigned, std::size_t, unsigned>> valid_edges_;
+  std::size_t n_edge_checks_;
+  bool use_thread_clones_;
+  std::vector<std::unique_ptr<ThreadClones>> thread_clones_;  /** @brief The clones of each thread of build() */
+
+  bool buildSkipEdges(typename EdgeEvaluator<FloatType>::Ptr edge_eval, int num_threads);
+
+  /** @brief Makes sure there are clones for each of 'n_threads' threads, dropping those of destroyed instances */
+  void resetThreadClones(const std::size_t n_threads);
+
+  /** @brief The clones for thread 'thread' of build(), or nullptr if thread clones are disabled */
+  ThreadClones* threadClones(const std::size_t thread) const noexcept;
+
+  /** @brief The out edges of a vertex, evaluated along with the rest of its block on first use */
+  const typename LadderGraph<FloatType>::EdgeList& deferredEdges(const std::size_t rung, const std::size_t index);
+
+  /** @brief Evaluates every block of edges deferred by the last build */
+  void evaluateDeferredEdges();
+
+  /** @brief The states of vertex_states_ */
+  enum VertexState : char
+  {
+    UNCHECKED = 0,
+    VALID,
+    INVALID
+  };
+
+  /**
+   * @brief Collision checks the unchecked vertices of a path and removes those in collision, see removeVertex(). Once
+   * the vertices are valid, runs the deferred checks of the edges of the path and removes those that fail.
+   * @param closing_edges The closing edges of a cyclic path, whose edge from the last vertex back to the first vertex
+   * is then checked as well
+   * @return True if every vertex and edge of the path is valid
+   */
+  bool validatePath(const std::vector<unsigned>& indices,
+                    std::vector<typename LadderGraph<FloatType>::EdgeList>* closing_edges = nullptr);
+
+  /** @brief Runs the deferred checks of an edge not checked before and removes it from 'edges' if they fail */
+  bool validateEdge(const std::size_t from_rung,
+                    const unsigned from_index,
+                    const std::size_t to_rung,
+                    const unsigned to_index,
+                    typename LadderGraph<FloatType>::EdgeList& edges);
+
+  /** @brief Makes a vertex found in collision a dead end of the graph by removing its out edges */
+  void removeVertex(const std::size_t rung, const std::size_t index);
+
+  /** @brief 'costs' with the removed vertices of the first or last rung excluded, see DAGSearch::run() */
+  std::vector<FloatType> validCosts(const std::size_t rung, const std::vector<FloatType>& costs) const;
+
+  /** @brief Appends the vertices of a path to 'solution', leaving out and recording the skipped rungs */
+  void extractSolution(const std::vector<unsigned>& indices, std::vector<FloatType>& solution);
 };
 
 using SolverF = Solver<float>;
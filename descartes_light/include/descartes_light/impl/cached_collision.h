@@ -0,0 +1,225 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2016, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef DESCARTES_LIGHT_CACHED_COLLISION_H
+#define DESCARTES_LIGHT_CACHED_COLLISION_H
+
+#include <descartes_light/visibility_control.h>
+#include <descartes_light/interface/collision_interface.h>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace descartes_light
+{
+/**
+ * @brief Counters of a CachedCollision
+ */
+struct CollisionCacheStatistics
+{
+  std::uint64_t hits = 0;       /** @brief Queries answered from the cache, each a check avoided */
+  std::uint64_t misses = 0;     /** @brief Queries forwarded to the wrapped collision interface */
+  std::uint64_t evictions = 0;  /** @brief Entries dropped to stay within the capacity */
+
+  /** @brief The fraction of queries answered from the cache, zero before the first query */
+  double hitRate() const { return (hits + misses) == 0 ? 0.0 : double(hits) / double(hits + misses); }
+};
+
+/** @brief Which entry a full CachedCollision drops to make room for a new one */
+enum class CollisionCacheEviction
+{
+  LRU,  /** @brief The least recently used entry */
+  FIFO  /** @brief The oldest entry; hits then leave the entry order alone */
+};
+
+/**
+ * @brief This takes a collision interface and caches its validity and distance results by joint state
+ *
+ * States are keyed by their joint values rounded to the given resolutions, so a state that was checked before, or one
+ * within the resolution of it, is answered without calling the wrapped collision interface. The results returned are
+ * those of the first state seen with that key; keep the resolutions well below the clearance the application needs.
+ * Dense paths and the redundant solutions of getRedundantSolutions() produce many such repeated states.
+ *
+ * The cache is a hash table split into stripes, each with its own lock, holding up to 'capacity' entries in total.
+ * It is shared by the clones of clone(), which clone the wrapped collision interface, so the threads of
+ * Solver::build() each check with their own copy (see ThreadClones) but share their results.
+ */
+template <typename FloatType>
+class CachedCollision : public CollisionInterface<FloatType>
+{
+public:
+  /**
+   * @param collision The collision interface whose results are cached
+   * @param resolution The rounding of every joint value in the cache key
+   * @param capacity The maximum number of states cached
+   * @param eviction Which entry to drop when the cache is full
+   * @param n_stripes The number of independently locked parts of the cache, at most 'capacity'
+   */
+  CachedCollision(typename CollisionInterface<FloatType>::Ptr collision,
+                  FloatType resolution = static_cast<FloatType>(1e-4),
+                  std::size_t capacity = 1 << 16,
+                  CollisionCacheEviction eviction = CollisionCacheEviction::LRU,
+                  std::size_t n_stripes = 16);
+
+  /**
+   * @param resolutions The rounding of each joint value in the cache key. Joints beyond its size use the last value.
+   */
+  CachedCollision(typename CollisionInterface<FloatType>::Ptr collision,
+                  std::vector<FloatType> resolutions,
+                  std::size_t capacity = 1 << 16,
+                  CollisionCacheEviction eviction = CollisionCacheEviction::LRU,
+                  std::size_t n_stripes = 16);
+
+  bool validate(const FloatType* pos, const std::size_t size) override;
+
+  FloatType distance(const FloatType* pos, const std::size_t size) override;
+
+  /** @brief Batched validation; only the states that miss the cache are forwarded, in a single batch */
+  std::size_t validateBatch(const FloatType* pos, const std::size_t size, const std::size_t n, char* valid) override;
+
+  /** @brief Batched distances; only the states that miss the cache are forwarded, in a single batch */
+  void distanceBatch(const FloatType* pos, const std::size_t size, const std::size_t n, FloatType* distances) override;
+
+  /** @brief A cache sharing the entries of this one, wrapping a clone of the collision interface */
+  std::shared_ptr<CollisionInterface<FloatType>> clone() const override;
+
+  /** @brief The counters summed over this cache and its clones */
+  CollisionCacheStatistics getStatistics() const;
+
+  /** @brief Empties the cache, shared with the clones, and resets the statistics */
+  void clear();
+
+private:
+  static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+  /** @brief What an entry knows about its state, and what a lookup needs to know */
+  enum Known : unsigned char
+  {
+    VALIDITY = 1,
+    DISTANCE = 2
+  };
+
+  struct Entry
+  {
+    std::vector<std::int64_t> key;
+    std::uint64_t hash;
+    unsigned char known;
+    bool valid;
+    FloatType distance;
+    std::size_t prev;
+    std::size_t next;
+  };
+
+  /** @brief An independently locked part of the cache: entries linked from most to least recently used or inserted */
+  struct Stripe
+  {
+    std::mutex mutex;
+    std::vector<Entry> entries;
+    std::unordered_map<std::uint64_t, std::size_t> index;
+    std::size_t capacity = 0;
+    std::size_t head = npos;
+    std::size_t tail = npos;
+    CollisionCacheStatistics stats;
+  };
+
+  /** @brief The cache shared by the clones */
+  struct Table
+  {
+    std::vector<FloatType> resolutions;
+    CollisionCacheEviction eviction;
+    std::vector<std::unique_ptr<Stripe>> stripes;
+  };
+
+  /** @brief The key of a single state, on the stack for up to 'stack_size' joints */
+  class StateKey
+  {
+  public:
+    explicit StateKey(const std::size_t size) : heap_(size > stack_size ? size : 0) {}
+
+    std::int64_t* data() { return heap_.empty() ? stack_ : heap_.data(); }
+
+  private:
+    static constexpr std::size_t stack_size = 16;
+    std::int64_t stack_[stack_size];
+    std::vector<std::int64_t> heap_;
+  };
+
+  /** @brief The scratch buffers of the batched queries of one thread */
+  struct BatchScratch
+  {
+    std::vector<std::int64_t> keys;
+    std::vector<std::uint64_t> hashes;
+    std::vector<std::size_t> missed;
+    std::vector<FloatType> missed_states;
+    std::vector<char> missed_valid;
+    std::vector<FloatType> missed_distances;
+  };
+
+  /** @brief The result of a lookup */
+  struct Result
+  {
+    unsigned char known = 0;
+    bool valid = false;
+    FloatType distance = 0;
+  };
+
+  CachedCollision(typename CollisionInterface<FloatType>::Ptr collision, std::shared_ptr<Table> table);
+
+  /** @brief Quantizes a state into 'key' and returns its hash */
+  std::uint64_t makeKey(const FloatType* pos, const std::size_t size, std::int64_t* key) const;
+
+  Stripe& stripe(const std::uint64_t hash) const;
+
+  /** @brief Looks up a state and counts a hit if the entry knows everything in 'wanted', otherwise a miss */
+  Result find(const std::int64_t* key, const std::size_t size, const std::uint64_t hash, unsigned char wanted) const;
+
+  /** @brief Adds what 'result' knows to the entry of a state, creating it and evicting another if need be */
+  void insert(const std::int64_t* key, const std::size_t size, const std::uint64_t hash, const Result& result) const;
+
+  /** @brief Whether a lookup result knows everything in 'wanted' */
+  static bool answers(const Result& result, const unsigned char wanted);
+
+  static void unlink(Stripe& stripe, std::size_t i);
+
+  static void pushFront(Stripe& stripe, std::size_t i);
+
+  typename CollisionInterface<FloatType>::Ptr collision_;
+  std::shared_ptr<Table> table_;
+  const std::uint64_t id_;
+
+  mutable std::mutex scratch_mutex_;
+  mutable std::vector<std::unique_ptr<BatchScratch>> scratch_;
+
+  /** @brief A new id, never reused */
+  static std::uint64_t nextId();
+
+  /**
+   * @brief The scratch of the calling thread, created on first use
+   *
+   * Kept per thread and per instance, so that threads sharing a cache, and a cache wrapping another, do not share it.
+   */
+  BatchScratch& threadScratch() const;
+};
+
+using CachedCollisionD = CachedCollision<double>;
+using CachedCollisionF = CachedCollision<float>;
+}  // namespace descartes_light
+
+#endif  // DESCARTES_LIGHT_CACHED_COLLISION_H
@@ -0,0 +1,420 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2016, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef DESCARTES_LIGHT_CACHED_COLLISION_HPP
+#define DESCARTES_LIGHT_CACHED_COLLISION_HPP
+
+#include <descartes_light/impl/cached_collision.h>
+#include <console_bridge/console.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+
+namespace descartes_light
+{
+template <typename FloatType>
+CachedCollision<FloatType>::CachedCollision(typename CollisionInterface<FloatType>::Ptr collision,
+                                            FloatType resolution,
+                                            std::size_t capacity,
+                                            CollisionCacheEviction eviction,
+                                            std::size_t n_stripes)
+  : CachedCollision(std::move(collision), std::vector<FloatType>(1, resolution), capacity, eviction, n_stripes)
+{
+}
+
+template <typename FloatType>
+CachedCollision<FloatType>::CachedCollision(typename CollisionInterface<FloatType>::Ptr collision,
+                                            std::vector<FloatType> resolutions,
+                                            std::size_t capacity,
+                                            CollisionCacheEviction eviction,
+                                            std::size_t n_stripes)
+  : collision_(std::move(collision)), table_(std::make_shared<Table>()), id_(nextId())
+{
+  if (resolutions.empty())
+  {
+    CONSOLE_BRIDGE_logError("CachedCollision needs at least one resolution, using 1e-4");
+    resolutions.push_back(static_cast<FloatType>(1e-4));
+  }
+
+  // Split the capacity exactly, every stripe holding at least one entry
+  capacity = std::max<std::size_t>(capacity, 1);
+  n_stripes = std::min(std::max<std::size_t>(n_stripes, 1), capacity);
+  table_->resolutions = std::move(resolutions);
+  table_->eviction = eviction;
+  for (std::size_t i = 0; i < n_stripes; ++i)
+  {
+    table_->stripes.emplace_back(new Stripe());
+    table_->stripes.back()->capacity = capacity / n_stripes + (i < capacity % n_stripes ? 1 : 0);
+  }
+}
+
+template <typename FloatType>
+CachedCollision<FloatType>::CachedCollision(typename CollisionInterface<FloatType>::Ptr collision,
+                                            std::shared_ptr<Table> table)
+  : collision_(std::move(collision)), table_(std::move(table)), id_(nextId())
+{
+}
+
+template <typename FloatType>
+bool CachedCollision<FloatType>::validate(const FloatType* pos, const std::size_t size)
+{
+  StateKey key(size);
+  const std::uint64_t hash = makeKey(pos, size, key.data());
+
+  Result result = find(key.data(), size, hash, VALIDITY);
+  if (result.known & VALIDITY)
+    return result.valid;
+
+  result.known = VALIDITY;
+  result.valid = collision_->validate(pos, size);
+  insert(key.data(), size, hash, result);
+  return result.valid;
+}
+
+template <typename FloatType>
+FloatType CachedCollision<FloatType>::distance(const FloatType* pos, const std::size_t size)
+{
+  StateKey key(size);
+  const std::uint64_t hash = makeKey(pos, size, key.data());
+
+  Result result = find(key.data(), size, hash, DISTANCE);
+  if (result.known & DISTANCE)
+    return result.distance;
+
+  result.known = DISTANCE;
+  result.distance = collision_->distance(pos, size);
+  insert(key.data(), size, hash, result);
+  return result.distance;
+}
+
+template <typename FloatType>
+std::size_t CachedCollision<FloatType>::validateBatch(const FloatType* pos,
+                                                      const std::size_t size,
+                                                      const std::size_t n,
+                                                      char* valid)
+{
+  // Look up every state first, so that the misses are checked in a single batch
+  BatchScratch& scratch = threadScratch();
+  std::vector<std::int64_t>& keys = scratch.keys;
+  std::vector<std::uint64_t>& hashes = scratch.hashes;
+  std::vector<std::size_t>& missed = scratch.missed;
+  std::vector<FloatType>& missed_states = scratch.missed_states;
+  std::vector<char>& missed_valid = scratch.missed_valid;
+  keys.resize(n * size);
+  hashes.resize(n);
+  missed.clear();
+  missed_states.clear();
+
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    hashes[i] = makeKey(pos + i * size, size, keys.data() + i * size);
+    const Result result = find(keys.data() + i * size, size, hashes[i], VALIDITY);
+    if (result.known & VALIDITY)
+    {
+      valid[i] = result.valid ? 1 : 0;
+    }
+    else
+    {
+      missed.push_back(i);
+      missed_states.insert(missed_states.end(), pos + i * size, pos + (i + 1) * size);
+    }
+  }
+
+  if (!missed.empty())
+  {
+    missed_valid.resize(missed.size());
+    collision_->validateBatch(missed_states.data(), size, missed.size(), missed_valid.data());
+
+    for (std::size_t m = 0; m < missed.size(); ++m)
+    {
+      const std::size_t i = missed[m];
+      Result result;
+      result.known = VALIDITY;
+      result.valid = missed_valid[m] != 0;
+      insert(keys.data() + i * size, size, hashes[i], result);
+      valid[i] = missed_valid[m];
+    }
+  }
+
+  return static_cast<std::size_t>(std::count_if(valid, valid + n, [](char v) { return v != 0; }));
+}
+
+template <typename FloatType>
+void CachedCollision<FloatType>::distanceBatch(const FloatType* pos,
+                                               const std::size_t size,
+                                               const std::size_t n,
+                                               FloatType* distances)
+{
+  BatchScratch& scratch = threadScratch();
+  std::vector<std::int64_t>& keys = scratch.keys;
+  std::vector<std::uint64_t>& hashes = scratch.hashes;
+  std::vector<std::size_t>& missed = scratch.missed;
+  std::vector<FloatType>& missed_states = scratch.missed_states;
+  std::vector<FloatType>& missed_distances = scratch.missed_distances;
+  keys.resize(n * size);
+  hashes.resize(n);
+  missed.clear();
+  missed_states.clear();
+
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    hashes[i] = makeKey(pos + i * size, size, keys.data() + i * size);
+    const Result result = find(keys.data() + i * size, size, hashes[i], DISTANCE);
+    if (result.known & DISTANCE)
+    {
+      distances[i] = result.distance;
+    }
+    else
+    {
+      missed.push_back(i);
+      missed_states.insert(missed_states.end(), pos + i * size, pos + (i + 1) * size);
+    }
+  }
+
+  if (missed.empty())
+    return;
+
+  missed_distances.resize(missed.size());
+  collision_->distanceBatch(missed_states.data(), size, missed.size(), missed_distances.data());
+
+  for (std::size_t m = 0; m < missed.size(); ++m)
+  {
+    const std::size_t i = missed[m];
+    Result result;
+    result.known = DISTANCE;
+    result.distance = missed_distances[m];
+    insert(keys.data() + i * size, size, hashes[i], result);
+    distances[i] = missed_distances[m];
+  }
+}
+
+template <typename FloatType>
+std::shared_ptr<CollisionInterface<FloatType>> CachedCollision<FloatType>::clone() const
+{
+  auto collision = collision_->clone();
+  return std::shared_ptr<CollisionInterface<FloatType>>(
+      new CachedCollision<FloatType>(collision ? std::move(collision) : collision_, table_));
+}
+
+template <typename FloatType>
+CollisionCacheStatistics CachedCollision<FloatType>::getStatistics() const
+{
+  CollisionCacheStatistics stats;
+  for (const auto& stripe : table_->stripes)
+  {
+    std::lock_guard<std::mutex> lock(stripe->mutex);
+    stats.hits += stripe->stats.hits;
+    stats.misses += stripe->stats.misses;
+    stats.evictions += stripe->stats.evictions;
+  }
+  return stats;
+}
+
+template <typename FloatType>
+void CachedCollision<FloatType>::clear()
+{
+  for (const auto& stripe : table_->stripes)
+  {
+    std::lock_guard<std::mutex> lock(stripe->mutex);
+    stripe->entries.clear();
+    stripe->index.clear();
+    stripe->head = npos;
+    stripe->tail = npos;
+    stripe->stats = CollisionCacheStatistics();
+  }
+}
+
+template <typename FloatType>
+std::uint64_t CachedCollision<FloatType>::nextId()
+{
+  // Never reused, so a thread never mistakes the scratch of a destroyed cache for one of a new cache
+  static std::atomic<std::uint64_t> next_id(0);
+  return next_id++;
+}
+
+template <typename FloatType>
+typename CachedCollision<FloatType>::BatchScratch& CachedCollision<FloatType>::threadScratch() const
+{
+  thread_local std::unordered_map<std::uint64_t, BatchScratch*> thread_scratch;
+
+  BatchScratch*& scratch = thread_scratch[id_];
+  if (!scratch)
+  {
+    std::unique_ptr<BatchScratch> new_scratch(new BatchScratch());
+
+    std::lock_guard<std::mutex> lock(scratch_mutex_);
+    scratch = new_scratch.get();
+    scratch_.push_back(std::move(new_scratch));
+  }
+  return *scratch;
+}
+
+template <typename FloatType>
+bool CachedCollision<FloatType>::answers(const Result& result, const unsigned char wanted)
+{
+  if ((wanted & VALIDITY) && !(result.known & VALIDITY))
+    return false;
+  if ((wanted & DISTANCE) && !(result.known & DISTANCE))
+    return false;
+  return true;
+}
+
+template <typename FloatType>
+std::uint64_t CachedCollision<FloatType>::makeKey(const FloatType* pos, const std::size_t size, std::int64_t* key) const
+{
+  const auto& resolutions = table_->resolutions;
+  std::uint64_t hash = size;
+  for (std::size_t i = 0; i < size; ++i)
+  {
+    key[i] = std::llround(pos[i] / resolutions[std::min(i, resolutions.size() - 1)]);
+    hash ^= std::hash<std::int64_t>()(key[i]) + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+  }
+
+  // Mix the bits, the stripe is chosen by the low ones
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+template <typename FloatType>
+typename CachedCollision<FloatType>::Stripe& CachedCollision<FloatType>::stripe(const std::uint64_t hash) const
+{
+  return *table_->stripes[hash % table_->stripes.size()];
+}
+
+template <typename FloatType>
+typename CachedCollision<FloatType>::Result CachedCollision<FloatType>::find(const std::int64_t* key,
+                                                                            const std::size_t size,
+                                                                            const std::uint64_t hash,
+                                                                            const unsigned char wanted) const
+{
+  Stripe& s = stripe(hash);
+  std::lock_guard<std::mutex> lock(s.mutex);
+
+  Result result;
+  auto it = s.index.find(hash);
+  if (it != s.index.end())
+  {
+    // Entries are indexed by hash alone, so a different state with the same hash is a miss
+    const Entry& entry = s.entries[it->second];
+    if (entry.key.size() == size && std::equal(entry.key.begin(), entry.key.end(), key))
+    {
+      result.known = entry.known;
+      result.valid = entry.valid;
+      result.distance = entry.distance;
+      if (table_->eviction == CollisionCacheEviction::LRU)
+      {
+        unlink(s, it->second);
+        pushFront(s, it->second);
+      }
+    }
+  }
+
+  if (answers(result, wanted))
+    ++s.stats.hits;
+  else
+    ++s.stats.misses;
+  return result;
+}
+
+template <typename FloatType>
+void CachedCollision<FloatType>::insert(const std::int64_t* key,
+                                        const std::size_t size,
+                                        const std::uint64_t hash,
+                                        const Result& result) const
+{
+  Stripe& s = stripe(hash);
+  std::lock_guard<std::mutex> lock(s.mutex);
+
+  auto it = s.index.find(hash);
+  std::size_t i;
+  if (it != s.index.end())
+  {
+    i = it->second;
+    Entry& entry = s.entries[i];
+    if (entry.key.size() == size && std::equal(entry.key.begin(), entry.key.end(), key))
+    {
+      // Another thread may have added to the entry since the lookup, keep what it knows
+      entry.known |= result.known;
+      if (result.known & VALIDITY)
+        entry.valid = result.valid;
+      if (result.known & DISTANCE)
+        entry.distance = result.distance;
+      return;
+    }
+
+    // A different state with the same hash, replace it
+    unlink(s, i);
+  }
+  else if (s.entries.size() < s.capacity)
+  {
+    i = s.entries.size();
+    s.entries.emplace_back();
+    s.index.emplace(hash, i);
+  }
+  else
+  {
+    // Recycle the last entry, along with the capacity of its key
+    i = s.tail;
+    unlink(s, i);
+    s.index.erase(s.entries[i].hash);
+    s.index.emplace(hash, i);
+    ++s.stats.evictions;
+  }
+
+  Entry& entry = s.entries[i];
+  entry.key.assign(key, key + size);
+  entry.hash = hash;
+  entry.known = result.known;
+  entry.valid = result.valid;
+  entry.distance = result.distance;
+  pushFront(s, i);
+}
+
+template <typename FloatType>
+void CachedCollision<FloatType>::unlink(Stripe& stripe, std::size_t i)
+{
+  Entry& entry = stripe.entries[i];
+  if (entry.prev != npos)
+    stripe.entries[entry.prev].next = entry.next;
+  else
+    stripe.head = entry.next;
+
+  if (entry.next != npos)
+    stripe.entries[entry.next].prev = entry.prev;
+  else
+    stripe.tail = entry.prev;
+}
+
+template <typename FloatType>
+void CachedCollision<FloatType>::pushFront(Stripe& stripe, std::size_t i)
+{
+  Entry& entry = stripe.entries[i];
+  entry.prev = npos;
+  entry.next = stripe.head;
+  if (stripe.head != npos)
+    stripe.entries[stripe.head].prev = i;
+  stripe.head = i;
+  if (stripe.tail == npos)
+    stripe.tail = i;
+}
+
+}  // namespace descartes_light
+
+#endif  // DESCARTES_LIGHT_CACHED_COLLISION_HPP
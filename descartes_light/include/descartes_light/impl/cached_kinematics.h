@@ -0,0 +1,155 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2016, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef DESCARTES_LIGHT_CACHED_KINEMATICS_H
+#define DESCARTES_LIGHT_CACHED_KINEMATICS_H
+
+#include <descartes_light/visibility_control.h>
+#include <descartes_light/interface/kinematics_interface.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace descartes_light
+{
+/**
+ * @brief Counters of a CachedKinematics
+ */
+struct IKCacheStatistics
+{
+  std::uint64_t hits = 0;
+  std::uint64_t misses = 0;
+
+  /** @brief The fraction of ik() poses answered from the cache, zero before the first query */
+  double hitRate() const { return (hits + misses) == 0 ? 0.0 : double(hits) / double(hits + misses); }
+};
+
+/**
+ * @brief This takes a kinematics object and caches its IK solutions by pose
+ *
+ * Poses are keyed by their position and orientation (unit quaternion) rounded to the given resolutions, so a pose
+ * that was solved before, or one within the resolution of it, is answered without calling the wrapped kinematics. The
+ * solutions returned are those of the first pose seen with that key; keep the resolutions well below the accuracy the
+ * application needs.
+ *
+ * Each thread that calls ik() gets its own bounded LRU cache, so lookups take no locks. Poses solved on one thread are
+ * therefore not seen by the others.
+ */
+template <typename FloatType>
+class CachedKinematics : public KinematicsInterface<FloatType>
+{
+public:
+  /**
+   * @param kinematics The kinematics whose IK solutions are cached
+   * @param position_resolution The rounding of the position in the cache key
+   * @param orientation_resolution The rounding of the quaternion components in the cache key (about half the angle in
+   * radians)
+   * @param capacity The maximum number of poses cached per thread
+   */
+  CachedKinematics(typename KinematicsInterface<FloatType>::ConstPtr kinematics,
+                   FloatType position_resolution = static_cast<FloatType>(1e-6),
+                   FloatType orientation_resolution = static_cast<FloatType>(1e-6),
+                   std::size_t capacity = 4096);
+
+  ~CachedKinematics() override;
+
+  bool ik(const Eigen::Transform<FloatType, 3, Eigen::Isometry>& p,
+          std::vector<FloatType>& solution_set) const override;
+
+  /** @brief Batched IK; only the poses that miss the cache are forwarded, in a single batch */
+  bool ik(const Eigen::Transform<FloatType, 3, Eigen::Isometry>* poses,
+          const std::size_t n,
+          std::vector<FloatType>& solution_set,
+          std::vector<std::size_t>& offsets) const override;
+
+  bool fk(const FloatType* pose, Eigen::Transform<FloatType, 3, Eigen::Isometry>& solution) const override;
+
+  int dof() const override;
+
+  void analyzeIK(const Eigen::Transform<FloatType, 3, Eigen::Isometry>& p) const override;
+
+  /** @brief The hits and misses summed over all threads */
+  IKCacheStatistics getStatistics() const;
+
+  /** @brief Empties the caches of all threads and resets the statistics. Must not run concurrently with ik(). */
+  void clear();
+
+private:
+  using Key = std::array<std::int64_t, 7>;
+
+  static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+  struct KeyHash
+  {
+    std::size_t operator()(const Key& key) const noexcept;
+  };
+
+  struct Entry
+  {
+    Key key;
+    std::vector<FloatType> solutions;
+    bool found;
+    std::size_t prev;
+    std::size_t next;
+  };
+
+  /** @brief The LRU cache of one thread: entries linked from most to least recently used */
+  struct Shard
+  {
+    std::vector<Entry> entries;
+    std::unordered_map<Key, std::size_t, KeyHash> index;
+    std::size_t head;
+    std::size_t tail;
+    std::atomic<std::uint64_t> hits;
+    std::atomic<std::uint64_t> misses;
+  };
+
+  typename KinematicsInterface<FloatType>::ConstPtr kinematics_;
+  FloatType position_resolution_;
+  FloatType orientation_resolution_;
+  std::size_t capacity_;
+  const std::uint64_t id_;
+
+  mutable std::mutex shards_mutex_;
+  mutable std::vector<std::unique_ptr<Shard>> shards_;
+
+  /** @brief The shard of the calling thread, created on first use */
+  Shard& threadShard() const;
+
+  Key makeKey(const Eigen::Transform<FloatType, 3, Eigen::Isometry>& p) const;
+
+  /** @brief The entry for 'key', moved to the front, or nullptr */
+  const Entry* find(Shard& shard, const Key& key) const;
+
+  /** @brief Stores solutions under 'key', evicting the least recently used entry if the shard is full */
+  void insert(Shard& shard, const Key& key, const FloatType* begin, const FloatType* end, bool found) const;
+
+  static void unlink(Shard& shard, std::size_t i);
+
+  static void pushFront(Shard& shard, std::size_t i);
+};
+
+using CachedKinematicsD = CachedKinematics<double>;
+using CachedKinematicsF = CachedKinematics<float>;
+}  // namespace descartes_light
+
+#endif  // DESCARTES_LIGHT_CACHED_KINEMATICS_H
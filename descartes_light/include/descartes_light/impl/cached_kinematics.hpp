@@ -0,0 +1,314 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2016, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef DESCARTES_LIGHT_CACHED_KINEMATICS_HPP
+#define DESCARTES_LIGHT_CACHED_KINEMATICS_HPP
+
+#include <descartes_light/impl/cached_kinematics.h>
+#include <console_bridge/console.h>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <sstream>
+
+namespace descartes_light
+{
+template <typename FloatType>
+CachedKinematics<FloatType>::CachedKinematics(typename KinematicsInterface<FloatType>::ConstPtr kinematics,
+                                              FloatType position_resolution,
+                                              FloatType orientation_resolution,
+                                              std::size_t capacity)
+  : kinematics_(std::move(kinematics))
+  , position_resolution_(position_resolution)
+  , orientation_resolution_(orientation_resolution)
+  , capacity_(std::max<std::size_t>(capacity, 1))
+  , id_([] {
+    // Never reused, so a thread never mistakes the shard of a destroyed cache for one of a new cache
+    static std::atomic<std::uint64_t> next_id(0);
+    return next_id++;
+  }())
+{
+}
+
+template <typename FloatType>
+CachedKinematics<FloatType>::~CachedKinematics() = default;
+
+template <typename FloatType>
+bool CachedKinematics<FloatType>::ik(const Eigen::Transform<FloatType, 3, Eigen::Isometry>& p,
+                                     std::vector<FloatType>& solution_set) const
+{
+  Shard& shard = threadShard();
+  const Key key = makeKey(p);
+
+  if (const Entry* entry = find(shard, key))
+  {
+    shard.hits.fetch_add(1, std::memory_order_relaxed);
+    solution_set.insert(solution_set.end(), entry->solutions.begin(), entry->solutions.end());
+    return entry->found;
+  }
+
+  shard.misses.fetch_add(1, std::memory_order_relaxed);
+  const std::size_t begin = solution_set.size();
+  const bool found = kinematics_->ik(p, solution_set);
+  insert(shard, key, solution_set.data() + begin, solution_set.data() + solution_set.size(), found);
+  return found;
+}
+
+template <typename FloatType>
+bool CachedKinematics<FloatType>::ik(const Eigen::Transform<FloatType, 3, Eigen::Isometry>* poses,
+                                     const std::size_t n,
+                                     std::vector<FloatType>& solution_set,
+                                     std::vector<std::size_t>& offsets) const
+{
+  Shard& shard = threadShard();
+
+  // Look up every pose first, so that the misses are solved in a single batch
+  std::vector<Key> keys(n);
+  std::vector<const Entry*> hits(n);
+  typename KinematicsInterface<FloatType>::PoseVector missed_poses;
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    keys[i] = makeKey(poses[i]);
+    hits[i] = find(shard, keys[i]);
+    if (!hits[i])
+      missed_poses.push_back(poses[i]);
+  }
+
+  std::vector<FloatType> missed_solutions;
+  std::vector<std::size_t> missed_offsets;
+  if (!missed_poses.empty())
+    kinematics_->ik(missed_poses.data(), missed_poses.size(), missed_solutions, missed_offsets);
+
+  shard.hits.fetch_add(n - missed_poses.size(), std::memory_order_relaxed);
+  shard.misses.fetch_add(missed_poses.size(), std::memory_order_relaxed);
+
+  offsets.resize(n + 1);
+  for (std::size_t i = 0, m = 0; i < n; ++i)
+  {
+    offsets[i] = solution_set.size();
+    if (hits[i])
+    {
+      solution_set.insert(solution_set.end(), hits[i]->solutions.begin(), hits[i]->solutions.end());
+    }
+    else
+    {
+      solution_set.insert(solution_set.end(),
+                          missed_solutions.data() + missed_offsets[m],
+                          missed_solutions.data() + missed_offsets[m + 1]);
+      ++m;
+    }
+  }
+  offsets[n] = solution_set.size();
+
+  // Only cache the misses once every hit has been copied out, as inserting may evict the entry of a hit
+  for (std::size_t i = 0, m = 0; i < n; ++i)
+  {
+    if (hits[i])
+      continue;
+
+    insert(shard,
+           keys[i],
+           missed_solutions.data() + missed_offsets[m],
+           missed_solutions.data() + missed_offsets[m + 1],
+           missed_offsets[m + 1] != missed_offsets[m]);
+    ++m;
+  }
+
+  return offsets[n] != offsets[0];
+}
+
+template <typename FloatType>
+bool CachedKinematics<FloatType>::fk(const FloatType* pose,
+                                     Eigen::Transform<FloatType, 3, Eigen::Isometry>& solution) const
+{
+  return kinematics_->fk(pose, solution);
+}
+
+template <typename FloatType>
+int CachedKinematics<FloatType>::dof() const
+{
+  return kinematics_->dof();
+}
+
+template <typename FloatType>
+void CachedKinematics<FloatType>::analyzeIK(const Eigen::Transform<FloatType, 3, Eigen::Isometry>& p) const
+{
+  const IKCacheStatistics stats = getStatistics();
+  std::stringstream ss;
+  ss << "IK cache: " << stats.hits << " hits, " << stats.misses << " misses, hit rate " << stats.hitRate();
+  CONSOLE_BRIDGE_logInform(ss.str().c_str());
+
+  kinematics_->analyzeIK(p);
+}
+
+template <typename FloatType>
+IKCacheStatistics CachedKinematics<FloatType>::getStatistics() const
+{
+  IKCacheStatistics stats;
+  std::lock_guard<std::mutex> lock(shards_mutex_);
+  for (const auto& shard : shards_)
+  {
+    stats.hits += shard->hits.load(std::memory_order_relaxed);
+    stats.misses += shard->misses.load(std::memory_order_relaxed);
+  }
+  return stats;
+}
+
+template <typename FloatType>
+void CachedKinematics<FloatType>::clear()
+{
+  std::lock_guard<std::mutex> lock(shards_mutex_);
+  for (const auto& shard : shards_)
+  {
+    shard->entries.clear();
+    shard->index.clear();
+    shard->head = npos;
+    shard->tail = npos;
+    shard->hits = 0;
+    shard->misses = 0;
+  }
+}
+
+template <typename FloatType>
+std::size_t CachedKinematics<FloatType>::KeyHash::operator()(const Key& key) const noexcept
+{
+  std::size_t h = 0;
+  for (std::int64_t k : key)
+    h ^= std::hash<std::int64_t>()(k) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+  return h;
+}
+
+template <typename FloatType>
+typename CachedKinematics<FloatType>::Shard& CachedKinematics<FloatType>::threadShard() const
+{
+  thread_local std::unordered_map<std::uint64_t, Shard*> thread_shards;
+
+  Shard*& shard = thread_shards[id_];
+  if (!shard)
+  {
+    std::unique_ptr<Shard> new_shard(new Shard());
+    new_shard->entries.reserve(capacity_);
+    new_shard->index.reserve(capacity_);
+    new_shard->head = npos;
+    new_shard->tail = npos;
+    new_shard->hits = 0;
+    new_shard->misses = 0;
+
+    std::lock_guard<std::mutex> lock(shards_mutex_);
+    shard = new_shard.get();
+    shards_.push_back(std::move(new_shard));
+  }
+  return *shard;
+}
+
+template <typename FloatType>
+typename CachedKinematics<FloatType>::Key
+CachedKinematics<FloatType>::makeKey(const Eigen::Transform<FloatType, 3, Eigen::Isometry>& p) const
+{
+  Eigen::Quaternion<FloatType> q(p.linear());
+  if (q.w() < 0)
+    q.coeffs() = -q.coeffs();  // q and -q are the same orientation
+
+  Key key;
+  for (Eigen::Index i = 0; i < 3; ++i)
+    key[static_cast<std::size_t>(i)] = std::llround(p.translation()(i) / position_resolution_);
+  for (Eigen::Index i = 0; i < 4; ++i)
+    key[static_cast<std::size_t>(3 + i)] = std::llround(q.coeffs()(i) / orientation_resolution_);
+  return key;
+}
+
+template <typename FloatType>
+const typename CachedKinematics<FloatType>::Entry* CachedKinematics<FloatType>::find(Shard& shard,
+                                                                                     const Key& key) const
+{
+  auto it = shard.index.find(key);
+  if (it == shard.index.end())
+    return nullptr;
+
+  unlink(shard, it->second);
+  pushFront(shard, it->second);
+  return &shard.entries[it->second];
+}
+
+template <typename FloatType>
+void CachedKinematics<FloatType>::insert(Shard& shard,
+                                         const Key& key,
+                                         const FloatType* begin,
+                                         const FloatType* end,
+                                         bool found) const
+{
+  auto it = shard.index.find(key);
+  std::size_t i;
+  if (it != shard.index.end())
+  {
+    i = it->second;
+    unlink(shard, i);
+  }
+  else if (shard.entries.size() < capacity_)
+  {
+    i = shard.entries.size();
+    shard.entries.emplace_back();
+    shard.index.emplace(key, i);
+  }
+  else
+  {
+    // Recycle the least recently used entry, along with the capacity of its solution vector
+    i = shard.tail;
+    unlink(shard, i);
+    shard.index.erase(shard.entries[i].key);
+    shard.index.emplace(key, i);
+  }
+
+  Entry& entry = shard.entries[i];
+  entry.key = key;
+  entry.solutions.assign(begin, end);
+  entry.found = found;
+  pushFront(shard, i);
+}
+
+template <typename FloatType>
+void CachedKinematics<FloatType>::unlink(Shard& shard, std::size_t i)
+{
+  Entry& entry = shard.entries[i];
+  if (entry.prev != npos)
+    shard.entries[entry.prev].next = entry.next;
+  else
+    shard.head = entry.next;
+
+  if (entry.next != npos)
+    shard.entries[entry.next].prev = entry.prev;
+  else
+    shard.tail = entry.prev;
+}
+
+template <typename FloatType>
+void CachedKinematics<FloatType>::pushFront(Shard& shard, std::size_t i)
+{
+  Entry& entry = shard.entries[i];
+  entry.prev = npos;
+  entry.next = shard.head;
+  if (shard.head != npos)
+    shard.entries[shard.head].prev = i;
+  shard.head = i;
+  if (shard.tail == npos)
+    shard.tail = i;
+}
+
+}  // namespace descartes_light
+
+#endif  // DESCARTES_LIGHT_CACHED_KINEMATICS_HPP
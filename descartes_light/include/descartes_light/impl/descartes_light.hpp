@@ -23,6 +23,8 @@
 #include <console_bridge/console.h>
 #include <sstream>
 #include <algorithm>
+#include <functional>
+#include <limits>
 
 #define UNUSED(x) (void)(x)
 
@@ -56,11 +58,96 @@ static void reportFailedVertices(const std::vector<std::size_t>& indices)
   }
 }
 
+static void reportDisconnections(const std::vector<std::pair<std::size_t, std::size_t>>& windows)
+{
+  if (windows.empty())
+    CONSOLE_BRIDGE_logInform("No disconnections");
+  else
+  {
+    std::stringstream ss;
+    ss << "Disconnected rungs:\n";
+    for (const auto& w : windows)
+      ss << "\t" << w.first << " - " << w.second << "\n";
+
+    CONSOLE_BRIDGE_logWarn(ss.str().c_str());
+  }
+}
+
+static void reportSkippedRungs(const std::vector<std::size_t>& indices)
+{
+  if (!indices.empty())
+  {
+    std::stringstream ss;
+    ss << "Skipped rungs:\n";
+    for (const auto& i : indices)
+      ss << "\t" << i << "\n";
+
+    CONSOLE_BRIDGE_logWarn(ss.str().c_str());
+  }
+}
+
 namespace descartes_light
 {
 template <typename FloatType>
-Solver<FloatType>::Solver(const std::size_t dof) : graph_{ dof }
+Solver<FloatType>::Solver(const std::size_t dof)
+  : graph_{ dof }
+  , max_skipped_rungs_(0)
+  , skip_penalty_(0.0)
+  , vertex_capacity_hint_(0)
+  , lazy_edges_(false)
+  , lazy_block_size_(1)
+  , edges_deferred_(false)
+  , n_evaluated_vertices_(0)
+  , lazy_collision_(false)
+  , collision_deferred_(false)
+  , n_collision_checks_(0)
+  , edge_checks_deferred_(false)
+  , n_edge_checks_(0)
+  , use_thread_clones_(true)
+{
+}
+
+template <typename FloatType>
+void Solver<FloatType>::setSkipping(const std::size_t max_skipped_rungs, const FloatType skip_penalty)
+{
+  max_skipped_rungs_ = max_skipped_rungs;
+  skip_penalty_ = skip_penalty;
+}
+
+template <typename FloatType>
+void Solver<FloatType>::setUseArena(const bool use_arena)
+{
+  graph_.setUseArena(use_arena);
+}
+
+template <typename FloatType>
+void Solver<FloatType>::setUseThreadClones(const bool use_thread_clones)
+{
+  use_thread_clones_ = use_thread_clones;
+  if (!use_thread_clones_)
+    thread_clones_.clear();
+}
+
+template <typename FloatType>
+void Solver<FloatType>::setLazyEdges(const bool lazy_edges, const std::size_t block_size)
+{
+  lazy_edges_ = lazy_edges;
+  lazy_block_size_ = std::max<std::size_t>(block_size, 1);
+}
+
+template <typename FloatType>
+void Solver<FloatType>::setLazyCollisionChecking(const bool lazy_collision)
+{
+  lazy_collision_ = lazy_collision;
+}
+
+template <typename FloatType>
+std::size_t Solver<FloatType>::getSavedCollisionChecks() const
 {
+  std::size_t n_unchecked = 0;
+  for (const auto& states : vertex_states_)
+    n_unchecked += static_cast<std::size_t>(std::count(states.begin(), states.end(), UNCHECKED));
+  return n_unchecked;
 }
 
 template <typename FloatType>
@@ -70,23 +157,45 @@ bool Solver<FloatType>::build(const std::vector<typename PositionSampler<FloatTy
                               int num_threads)
 {
   graph_.resize(trajectory.size());
+  graph_.resetArenas(static_cast<std::size_t>(std::max(num_threads, 1)));
+  resetThreadClones(static_cast<std::size_t>(std::max(num_threads, 1)));
+  edge_eval_ = edge_eval;
   failed_vertices_.clear();
   failed_edges_.clear();
+  edges_deferred_ = false;
+  evaluated_blocks_.clear();
+  n_evaluated_vertices_ = 0;
+  collision_deferred_ = lazy_collision_;
+  samplers_.clear();
+  vertex_states_.clear();
+  n_collision_checks_ = 0;
+  edge_checks_deferred_ = edge_eval != nullptr && edge_eval->hasDeferredChecks();
+  valid_edges_.clear();
+  n_edge_checks_ = 0;
 
   // Build Vertices
+  // The samplers write straight into the rung storage, which keeps its capacity from the previous build. Rungs that
+  // are new, or smaller than the largest rung of the previous build, are grown to that size up front.
   long num_waypoints = static_cast<long>(trajectory.size());
   long cnt = 0;
 #pragma omp parallel for num_threads(num_threads)
   for (long i = 0; i < static_cast<long>(trajectory.size()); ++i)
   {
-    std::vector<FloatType> vertex_data;
-    if (trajectory[static_cast<size_t>(i)]->sample(vertex_data))
+    ThreadCloneScope clone_scope(threadClones(static_cast<std::size_t>(omp_get_thread_num())));
+    auto& rung = graph_.getRung(static_cast<size_t>(i));
+    rung.data.clear();
+    if (rung.data.capacity() < vertex_capacity_hint_)
+      rung.data.reserve(vertex_capacity_hint_);
+
+    graph_.getSkipEdges(static_cast<size_t>(i)).clear();
+    const auto& sampler = trajectory[static_cast<size_t>(i)];
+    if (collision_deferred_ ? sampler->sampleUnchecked(rung.data) : sampler->sample(rung.data))
     {
-      graph_.getRung(static_cast<size_t>(i)).data = std::move(vertex_data);
-      graph_.getRung(static_cast<size_t>(i)).timing = times[static_cast<size_t>(i)];
+      rung.timing = times[static_cast<size_t>(i)];
     }
     else
     {
+      graph_.clearVertices(static_cast<size_t>(i));
 #pragma omp critical
       {
         failed_vertices_.push_back(static_cast<size_t>(i));
@@ -103,15 +212,46 @@ bool Solver<FloatType>::build(const std::vector<typename PositionSampler<FloatTy
 #endif
   }
 
+  vertex_capacity_hint_ = 0;
+  for (std::size_t i = 0; i < graph_.size(); ++i)
+    vertex_capacity_hint_ = std::max(vertex_capacity_hint_, graph_.getRung(i).data.size());
+
+  if (collision_deferred_)
+  {
+    samplers_ = trajectory;
+    vertex_states_.resize(graph_.size());
+    for (std::size_t i = 0; i < graph_.size(); ++i)
+      vertex_states_[i].assign(graph_.rungSize(i), UNCHECKED);
+  }
+
+  // Leave the edges to search(), which evaluates those it needs
+  if (lazy_edges_ && max_skipped_rungs_ == 0)
+  {
+    edges_deferred_ = true;
+    evaluated_blocks_.resize(graph_.size());
+    for (std::size_t i = 0; i + 1 < graph_.size(); ++i)
+    {
+      graph_.getEdges(i).resize(graph_.rungSize(i));
+      evaluated_blocks_[i].assign((graph_.rungSize(i) + lazy_block_size_ - 1) / lazy_block_size_, 0);
+    }
+
+    std::sort(failed_vertices_.begin(), failed_vertices_.end());
+    reportFailedVertices(failed_vertices_);
+    return failed_vertices_.empty();
+  }
+
   // Build Edges
   cnt = 0;
 #pragma omp parallel for num_threads(num_threads)
   for (long i = 1; i < static_cast<long>(trajectory.size()); ++i)
   {
+    ArenaScope arena_scope(graph_.arena(static_cast<std::size_t>(omp_get_thread_num())));
+    ThreadCloneScope clone_scope(threadClones(static_cast<std::size_t>(omp_get_thread_num())));
     const auto& from = graph_.getRung(static_cast<size_t>(i) - static_cast<size_t>(1));
     const auto& to = graph_.getRung(static_cast<size_t>(i));
 
-    if (!edge_eval->evaluate(from, to, graph_.getEdges(static_cast<size_t>(i) - static_cast<size_t>(1))))
+    if (!ThreadClones::local(edge_eval)->evaluate(
+            from, to, graph_.getEdges(static_cast<size_t>(i) - static_cast<size_t>(1))))
     {
 #pragma omp critical
       {
@@ -137,33 +277,496 @@ bool Solver<FloatType>::build(const std::vector<typename PositionSampler<FloatTy
   reportFailedVertices(failed_vertices_);
   reportFailedEdges(failed_edges_);
 
-  return failed_edges_.empty() && failed_vertices_.empty();
+  if (failed_edges_.empty() && failed_vertices_.empty())
+    return true;
+
+  if (max_skipped_rungs_ == 0)
+    return false;
+
+  return buildSkipEdges(edge_eval, num_threads);
+}
+
+template <typename FloatType>
+bool Solver<FloatType>::buildSkipEdges(typename EdgeEvaluator<FloatType>::Ptr edge_eval, int num_threads)
+{
+  const auto breaks = DAGSearch<FloatType>::findDisconnections(graph_);
+  const auto spans = [&breaks](std::size_t from, std::size_t to, const std::pair<std::size_t, std::size_t>& b) {
+    return from < b.second && to > b.first;
+  };
+
+  // Skip edges are only evaluated around the breaks in the ladder
+#pragma omp parallel for num_threads(num_threads)
+  for (long i = 0; i < static_cast<long>(graph_.size()); ++i)
+  {
+    const auto from_index = static_cast<std::size_t>(i);
+    if (graph_.rungSize(from_index) == 0)
+      continue;
+
+    ArenaScope arena_scope(graph_.arena(static_cast<std::size_t>(omp_get_thread_num())));
+    ThreadCloneScope clone_scope(threadClones(static_cast<std::size_t>(omp_get_thread_num())));
+    EdgeEvaluator<FloatType>* local_edge_eval = ThreadClones::local(edge_eval);
+
+    for (std::size_t n_skipped = 1; n_skipped <= max_skipped_rungs_ && from_index + n_skipped + 1 < graph_.size();
+         ++n_skipped)
+    {
+      const std::size_t to_index = from_index + n_skipped + 1;
+      if (graph_.rungSize(to_index) == 0 ||
+          std::none_of(breaks.begin(), breaks.end(), [&](const std::pair<std::size_t, std::size_t>& b) {
+            return spans(from_index, to_index, b);
+          }))
+        continue;
+
+      // The skip edge gets the time budget of all the motions it replaces
+      Rung_<FloatType> to;
+      to.data = graph_.getRung(to_index).data;
+      for (std::size_t r = from_index + 1; r <= to_index; ++r)
+      {
+        const auto& timing = graph_.getRung(r).timing;
+        if (timing.upper == static_cast<FloatType>(0.0))
+        {
+          to.timing.upper = static_cast<FloatType>(0.0);
+          break;
+        }
+        to.timing.upper += timing.upper;
+      }
+
+      SkipEdges_<FloatType> skip;
+      skip.to_rung = to_index;
+      if (!local_edge_eval->evaluate(graph_.getRung(from_index), to, skip.edges))
+        continue;
+
+      const FloatType penalty = skip_penalty_ * static_cast<FloatType>(n_skipped);
+      for (auto& edges : skip.edges)
+        for (auto& edge : edges)
+          edge.cost += penalty;
+
+      graph_.getSkipEdges(from_index).push_back(std::move(skip));
+    }
+  }
+
+  // Report whether every break is spanned by at least one skip edge
+  bool bypassed = true;
+  for (const auto& b : breaks)
+  {
+    bool spanned = false;
+    for (std::size_t from_index = 0; from_index < graph_.size() && !spanned; ++from_index)
+      for (const auto& skip : graph_.getSkipEdges(from_index))
+        spanned = spanned || spans(from_index, skip.to_rung, b);
+
+    bypassed = bypassed && spanned;
+  }
+
+  return bypassed;
 }
 
 template <typename FloatType>
 bool Solver<FloatType>::search(std::vector<FloatType>& solution)
 {
+  return search(solution, std::vector<FloatType>(), std::vector<FloatType>());
+}
+
+template <typename FloatType>
+bool Solver<FloatType>::search(std::vector<FloatType>& solution,
+                               const std::vector<FloatType>& initial_costs,
+                               const std::vector<FloatType>& terminal_costs)
+{
+  if (graph_.size() == 0)
+    return false;
+
+  if (!initial_costs.empty() && initial_costs.size() != graph_.rungSize(0))
+  {
+    CONSOLE_BRIDGE_logError("The number of initial costs does not match the size of the first rung");
+    return false;
+  }
+
+  if (!terminal_costs.empty() && terminal_costs.size() != graph_.rungSize(graph_.size() - 1))
+  {
+    CONSOLE_BRIDGE_logError("The number of terminal costs does not match the size of the last rung");
+    return false;
+  }
+
+  // With lazy collision checking or deferred edge checks, search until the path found is valid
   DAGSearch<FloatType> s(graph_);
-  const auto cost = s.run();
+  FloatType cost;
+  std::size_t n_searches = 0;
+  do
+  {
+    const auto first_costs = validCosts(0, initial_costs);
+    const auto last_costs = validCosts(graph_.size() - 1, terminal_costs);
+    ++n_searches;
+
+    if (edges_deferred_)
+    {
+      ArenaScope arena_scope(graph_.arena(0));
+      using std::placeholders::_1;
+      using std::placeholders::_2;
+      cost = s.runLazy(std::bind(&Solver<FloatType>::deferredEdges, this, _1, _2), first_costs, last_costs);
+    }
+    else
+    {
+      cost = s.run(first_costs, last_costs);
+    }
+  } while ((collision_deferred_ || edge_checks_deferred_) && cost != std::numeric_limits<FloatType>::max() &&
+           !validatePath(s.shortestPath()));
+
+  if (edges_deferred_)
+  {
+    std::stringstream ss;
+    ss << "Evaluated the out edges of " << n_evaluated_vertices_ << " of " << graph_.numVertices() << " vertices";
+    CONSOLE_BRIDGE_logInform(ss.str().c_str());
+  }
+
+  if (collision_deferred_)
+  {
+    std::stringstream ss;
+    ss << "Collision checked " << n_collision_checks_ << " of " << graph_.numVertices() << " vertices in "
+       << n_searches << " searches, " << getSavedCollisionChecks() << " checks saved";
+    CONSOLE_BRIDGE_logInform(ss.str().c_str());
+  }
+
+  if (edge_checks_deferred_)
+  {
+    std::stringstream ss;
+    ss << "Ran the deferred checks of " << n_edge_checks_ << " edges in " << n_searches << " searches";
+    CONSOLE_BRIDGE_logInform(ss.str().c_str());
+  }
 
   if (cost == std::numeric_limits<FloatType>::max())
     return false;
 
-  const auto indices = s.shortestPath();
+  extractSolution(s.shortestPath(), solution);
 
-  for (std::size_t i = 0; i < indices.size(); ++i)
+  std::stringstream ss;
+  ss << "Solution found w/ cost = " << cost;
+  CONSOLE_BRIDGE_logInform(ss.str().c_str());
+
+  return true;
+}
+
+template <typename FloatType>
+bool Solver<FloatType>::searchCyclic(std::vector<FloatType>& solution)
+{
+  if (graph_.size() == 0)
   {
-    const auto* pose = graph_.vertex(i, indices[i]);
-    solution.insert(end(solution), pose, pose + graph_.dof());
+    CONSOLE_BRIDGE_logError("The graph must be built before searching for a closed path");
+    return false;
+  }
+
+  return searchCyclic(solution, graph_.getRung(0).timing);
+}
+
+template <typename FloatType>
+bool Solver<FloatType>::searchCyclic(std::vector<FloatType>& solution,
+                                     const descartes_core::TimingConstraint<FloatType>& closing_timing)
+{
+  if (edge_eval_ == nullptr || graph_.size() == 0)
+  {
+    CONSOLE_BRIDGE_logError("The graph must be built before searching for a closed path");
+    return false;
+  }
+
+  evaluateDeferredEdges();
+
+  // The edge evaluators take the timing of a motion from the rung it leads into
+  Rung_<FloatType> closing;
+  closing.timing = closing_timing;
+  closing.data = graph_.getRung(0).data;
+
+  std::vector<typename LadderGraph<FloatType>::EdgeList> closing_edges;
+  edge_eval_->evaluate(graph_.getRung(graph_.size() - 1), closing, closing_edges);
+
+  DAGSearch<FloatType> s(graph_);
+  FloatType cost;
+  for (;;)
+  {
+    // The closing edges are out edges of the last rung; a start vertex in collision has no out edges of its own
+    if (collision_deferred_)
+      for (std::size_t index = 0; index < closing_edges.size(); ++index)
+        if (vertex_states_.back()[index] == INVALID)
+          closing_edges[index].clear();
+
+    cost = s.runCyclic(closing_edges);
+    if ((!collision_deferred_ && !edge_checks_deferred_) || cost == std::numeric_limits<FloatType>::max() ||
+        validatePath(s.shortestCycle(), &closing_edges))
+      break;
   }
 
+  if (cost == std::numeric_limits<FloatType>::max())
+    return false;
+
+  extractSolution(s.shortestCycle(), solution);
+
   std::stringstream ss;
-  ss << "Solution found w/ cost = " << cost;
+  ss << "Closed path found w/ cost = " << cost;
   CONSOLE_BRIDGE_logInform(ss.str().c_str());
 
   return true;
 }
 
+template <typename FloatType>
+void Solver<FloatType>::resetThreadClones(const std::size_t n_threads)
+{
+  if (!use_thread_clones_)
+    return;
+
+  // Keep the clones of the instances still alive, so that rebuilding with the same samplers clones nothing
+  for (auto& clones : thread_clones_)
+    clones->dropExpired();
+
+  while (thread_clones_.size() < n_threads)
+    thread_clones_.emplace_back(new ThreadClones());
+}
+
+template <typename FloatType>
+ThreadClones* Solver<FloatType>::threadClones(const std::size_t thread) const noexcept
+{
+  return thread < thread_clones_.size() ? thread_clones_[thread].get() : nullptr;
+}
+
+template <typename FloatType>
+const typename LadderGraph<FloatType>::EdgeList& Solver<FloatType>::deferredEdges(const std::size_t rung,
+                                                                                  const std::size_t index)
+{
+  auto& edges = graph_.getEdges(rung);
+  const std::size_t block = index / lazy_block_size_;
+  if (evaluated_blocks_[rung][block])
+    return edges[index];
+
+  evaluated_blocks_[rung][block] = 1;
+
+  const std::size_t first = block * lazy_block_size_;
+  const std::size_t last = std::min(first + lazy_block_size_, graph_.rungSize(rung));
+  const auto& data = graph_.getRung(rung).data;
+
+  deferred_from_.timing = graph_.getRung(rung).timing;
+  deferred_from_.data.assign(data.begin() + static_cast<long>(first * graph_.dof()),
+                             data.begin() + static_cast<long>(last * graph_.dof()));
+
+  // The lists moved out by the previous block are empty, so only the outer vector is reused
+  deferred_edges_.clear();
+  edge_eval_->evaluate(deferred_from_, graph_.getRung(rung + 1), deferred_edges_);
+  for (std::size_t i = 0; i < deferred_edges_.size() && first + i < last; ++i)
+    edges[first + i] = std::move(deferred_edges_[i]);
+
+  n_evaluated_vertices_ += last - first;
+
+  // Vertices found in collision stay dead ends, see removeVertex()
+  if (collision_deferred_)
+    for (std::size_t i = first; i < last; ++i)
+      if (vertex_states_[rung][i] == INVALID)
+        edges[i].clear();
+
+  return edges[index];
+}
+
+template <typename FloatType>
+void Solver<FloatType>::evaluateDeferredEdges()
+{
+  if (!edges_deferred_)
+    return;
+
+  ArenaScope arena_scope(graph_.arena(0));
+  for (std::size_t rung = 0; rung < evaluated_blocks_.size(); ++rung)
+    for (std::size_t block = 0; block < evaluated_blocks_[rung].size(); ++block)
+      deferredEdges(rung, block * lazy_block_size_);
+
+  edges_deferred_ = false;
+}
+
+template <typename FloatType>
+bool Solver<FloatType>::validatePath(const std::vector<unsigned>& indices,
+                                     std::vector<typename LadderGraph<FloatType>::EdgeList>* closing_edges)
+{
+  bool valid = true;
+  for (std::size_t rung = 0; collision_deferred_ && rung < indices.size(); ++rung)
+  {
+    const unsigned index = indices[rung];
+    if (index == DAGSearch<FloatType>::skipped_rung || vertex_states_[rung][index] != UNCHECKED)
+      continue;
+
+    ++n_collision_checks_;
+    if (samplers_[rung]->isValid(graph_.vertex(rung, index)))
+    {
+      vertex_states_[rung][index] = VALID;
+      continue;
+    }
+
+    removeVertex(rung, index);
+    valid = false;
+  }
+
+  // The edge checks are usually the more expensive ones, so they wait until the vertices are valid
+  if (!valid || !edge_checks_deferred_ || indices.empty())
+    return valid;
+
+  std::size_t from_rung = 0;
+  for (std::size_t rung = 1; rung < indices.size(); ++rung)
+  {
+    if (indices[rung] == DAGSearch<FloatType>::skipped_rung)
+      continue;
+
+    const unsigned from_index = indices[from_rung];
+    auto* edges = &graph_.getEdges(from_rung)[from_index];
+    if (rung != from_rung + 1)
+      for (auto& skip : graph_.getSkipEdges(from_rung))
+        if (skip.to_rung == rung)
+          edges = &skip.edges[from_index];
+
+    if (!validateEdge(from_rung, from_index, rung, indices[rung], *edges))
+      valid = false;
+    from_rung = rung;
+  }
+
+  if (closing_edges)
+  {
+    const unsigned from_index = indices[from_rung];
+    if (!validateEdge(from_rung, from_index, 0, indices[0], (*closing_edges)[from_index]))
+      valid = false;
+  }
+
+  return valid;
+}
+
+template <typename FloatType>
+bool Solver<FloatType>::validateEdge(const std::size_t from_rung,
+                                     const unsigned from_index,
+                                     const std::size_t to_rung,
+                                     const unsigned to_index,
+                                     typename LadderGraph<FloatType>::EdgeList& edges)
+{
+  const auto key = std::make_tuple(from_rung, from_index, to_rung, to_index);
+  if (valid_edges_.count(key) != 0)
+    return true;
+
+  ++n_edge_checks_;
+  if (edge_eval_->isValid(graph_.vertex(from_rung, from_index), graph_.vertex(to_rung, to_index), graph_.dof()))
+  {
+    valid_edges_.insert(key);
+    return true;
+  }
+
+  edges.erase(std::remove_if(edges.begin(),
+                             edges.end(),
+                             [to_index](const typename LadderGraph<FloatType>::Rung::Edge& edge) {
+                               return edge.idx == to_index;
+                             }),
+              edges.end());
+  return false;
+}
+
+template <typename FloatType>
+void Solver<FloatType>::removeVertex(const std::size_t rung, const std::size_t index)
+{
+  vertex_states_[rung][index] = INVALID;
+
+  // Without out edges the vertex is a dead end, so no path through it reaches the last rung. Vertices of the first and
+  // last rung are excluded through their initial and terminal costs instead, see validCosts().
+  auto& edges = graph_.getEdges(rung);
+  if (index < edges.size())
+    edges[index].clear();
+  for (auto& skip : graph_.getSkipEdges(rung))
+    skip.edges[index].clear();
+
+  const auto& states = vertex_states_[rung];
+  if (std::all_of(states.begin(), states.end(), [](char state) { return state == INVALID; }))
+  {
+    std::stringstream ss;
+    ss << "Every vertex of rung " << rung << " is in collision";
+    CONSOLE_BRIDGE_logWarn(ss.str().c_str());
+  }
+}
+
+template <typename FloatType>
+std::vector<FloatType> Solver<FloatType>::validCosts(const std::size_t rung, const std::vector<FloatType>& costs) const
+{
+  if (!collision_deferred_ ||
+      std::find(vertex_states_[rung].begin(), vertex_states_[rung].end(), INVALID) == vertex_states_[rung].end())
+    return costs;
+
+  std::vector<FloatType> valid_costs = costs;
+  valid_costs.resize(graph_.rungSize(rung), static_cast<FloatType>(0.0));
+  for (std::size_t index = 0; index < valid_costs.size(); ++index)
+    if (vertex_states_[rung][index] == INVALID)
+      valid_costs[index] = std::numeric_limits<FloatType>::max();
+
+  return valid_costs;
+}
+
+template <typename FloatType>
+void Solver<FloatType>::extractSolution(const std::vector<unsigned>& indices, std::vector<FloatType>& solution)
+{
+  skipped_rungs_.clear();
+  for (std::size_t i = 0; i < indices.size(); ++i)
+  {
+    if (indices[i] == DAGSearch<FloatType>::skipped_rung)
+    {
+      skipped_rungs_.push_back(i);
+      continue;
+    }
+
+    const auto* pose = graph_.vertex(i, indices[i]);
+    solution.insert(end(solution), pose, pose + graph_.dof());
+  }
+
+  reportSkippedRungs(skipped_rungs_);
+}
+
+template <typename FloatType>
+std::vector<FloatType> Solver<FloatType>::getStartCosts(const std::vector<FloatType>& start_state) const
+{
+  if (edge_eval_ == nullptr || graph_.size() == 0)
+  {
+    CONSOLE_BRIDGE_logError("The graph must be built before computing start costs");
+    return std::vector<FloatType>();
+  }
+
+  assert(start_state.size() == graph_.dof());
+  Rung_<FloatType> seed;
+  seed.data = start_state;
+
+  std::vector<typename LadderGraph<FloatType>::EdgeList> edges;
+  std::vector<FloatType> costs(graph_.rungSize(0), std::numeric_limits<FloatType>::max());
+  edge_eval_->evaluate(seed, graph_.getRung(0), edges);
+  if (!edges.empty())
+    for (const auto& edge : edges.front())
+      costs[edge.idx] = std::min(costs[edge.idx], edge.cost);
+
+  return costs;
+}
+
+template <typename FloatType>
+std::vector<FloatType> Solver<FloatType>::getGoalCosts(const std::vector<FloatType>& goal_state) const
+{
+  if (edge_eval_ == nullptr || graph_.size() == 0)
+  {
+    CONSOLE_BRIDGE_logError("The graph must be built before computing goal costs");
+    return std::vector<FloatType>();
+  }
+
+  assert(goal_state.size() == graph_.dof());
+  Rung_<FloatType> goal;
+  goal.data = goal_state;
+
+  std::vector<typename LadderGraph<FloatType>::EdgeList> edges;
+  std::vector<FloatType> costs(graph_.rungSize(graph_.size() - 1), std::numeric_limits<FloatType>::max());
+  edge_eval_->evaluate(graph_.getRung(graph_.size() - 1), goal, edges);
+  for (std::size_t index = 0; index < edges.size() && index < costs.size(); ++index)
+    for (const auto& edge : edges[index])
+      costs[index] = std::min(costs[index], edge.cost);
+
+  return costs;
+}
+
+template <typename FloatType>
+std::vector<std::pair<std::size_t, std::size_t>> Solver<FloatType>::findDisconnections()
+{
+  evaluateDeferredEdges();
+
+  const auto windows = DAGSearch<FloatType>::findDisconnections(graph_);
+  reportDisconnections(windows);
+  return windows;
+}
+
 }  // namespace descartes_light
 
 #endif  // DESCARTES_LIGHT_IMPL_DESCARTES_LIGHT_HPP
@@ -59,6 +59,8 @@ public:
                    const Eigen::Matrix<FloatType, 2, 1>& rail_sample_resolution,
                    const FloatType robot_reach);
 
+  using KinematicsInterface<FloatType>::ik;
+
   bool ik(const Eigen::Transform<FloatType, 3, Eigen::Isometry>& p,
           std::vector<FloatType>& solution_set) const override;
 
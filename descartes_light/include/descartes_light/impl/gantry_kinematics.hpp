@@ -62,9 +62,36 @@ bool GantryKinematics<FloatType>::ik(const Eigen::Transform<FloatType, 3, Eigen:
   const FloatType res_y =
       (y_range[1] - y_range[0]) / std::ceil((y_range[1] - y_range[0]) / rail_sample_resolution_.y());
 
+  // Solve every rail position in a single batch so the robot kinematics can share its setup across them
+  std::vector<Eigen::Matrix<FloatType, 2, 1>, Eigen::aligned_allocator<Eigen::Matrix<FloatType, 2, 1>>> rail_poses;
+  typename KinematicsInterface<FloatType>::PoseVector in_robot;
   for (FloatType x = x_range[0]; x < x_range[1]; x += res_x)
+  {
     for (FloatType y = y_range[0]; y < y_range[1]; y += res_y)
-      ikAt(p, Eigen::Matrix<FloatType, 2, 1>(x, y), solution_set);
+    {
+      const Eigen::Transform<FloatType, 3, Eigen::Isometry> world_to_robot_base =
+          world_to_rail_base_ * Eigen::Translation<FloatType, 3>(x, y, static_cast<FloatType>(0.0)) *
+          rail_base_to_robot_base_;
+      rail_poses.emplace_back(x, y);
+      in_robot.push_back(world_to_robot_base.inverse() * p);
+    }
+  }
+
+  std::vector<FloatType> sols;
+  std::vector<std::size_t> offsets;
+  if (!robot_kinematics_->ik(in_robot.data(), in_robot.size(), sols, offsets))
+    return !solution_set.empty();
+
+  const std::size_t robot_dof = static_cast<std::size_t>(robot_kinematics_->dof());
+  solution_set.reserve(solution_set.size() + (sols.size() / robot_dof) * (robot_dof + 2));
+  for (std::size_t r = 0; r < rail_poses.size(); ++r)
+  {
+    for (std::size_t i = offsets[r]; i < offsets[r + 1]; i += robot_dof)
+    {
+      solution_set.insert(end(solution_set), rail_poses[r].data(), rail_poses[r].data() + 2);  // The X-Y rail pose
+      solution_set.insert(end(solution_set), sols.data() + i, sols.data() + i + robot_dof);  // The robot configuration
+    }
+  }
 
   return !solution_set.empty();
 }
@@ -23,11 +23,25 @@
 namespace descartes_light
 {
 template <typename FloatType>
-LadderGraph<FloatType>::LadderGraph(const std::size_t dof) noexcept : dof_(dof)
+LadderGraph<FloatType>::LadderGraph(const std::size_t dof) noexcept : dof_(dof), use_arena_(false)
 {
   assert(dof != 0);
 }
 
+template <typename FloatType>
+LadderGraph<FloatType>::LadderGraph(const LadderGraph& other)
+  : dof_(other.dof_), use_arena_(false), rungs_(heapCopy(other.rungs_))
+{
+}
+
+template <typename FloatType>
+std::vector<typename LadderGraph<FloatType>::Rung> LadderGraph<FloatType>::heapCopy(const std::vector<Rung>& rungs)
+{
+  // Copies of the edge lists take the current arena, see ArenaAllocator::select_on_container_copy_construction()
+  ArenaScope heap_scope(nullptr);
+  return rungs;
+}
+
 template <typename FloatType>
 void LadderGraph<FloatType>::resize(const std::size_t n_rungs)
 {
@@ -74,6 +88,27 @@ LadderGraph<FloatType>::getEdges(const std::size_t index) const noexcept
   return rungs_[index].edges;
 }
 
+template <typename FloatType>
+std::vector<typename LadderGraph<FloatType>::SkipEdges>&
+LadderGraph<FloatType>::getSkipEdges(const std::size_t index) noexcept
+{
+  return const_cast<std::vector<SkipEdges>&>(static_cast<const LadderGraph&>(*this).getSkipEdges(index));
+}
+
+template <typename FloatType>
+const std::vector<typename LadderGraph<FloatType>::SkipEdges>&
+LadderGraph<FloatType>::getSkipEdges(const std::size_t index) const noexcept
+{
+  assert(index < rungs_.size());
+  return rungs_[index].skip_edges;
+}
+
+template <typename FloatType>
+bool LadderGraph<FloatType>::hasSkipEdges() const noexcept
+{
+  return std::any_of(rungs_.cbegin(), rungs_.cend(), [](const Rung& r) { return !r.skip_edges.empty(); });
+}
+
 template <typename FloatType>
 std::size_t LadderGraph<FloatType>::rungSize(const std::size_t index) const noexcept
 {
@@ -158,6 +193,7 @@ template <typename FloatType>
 void LadderGraph<FloatType>::clearEdges(const std::size_t index)
 {
   rungs_[index].edges.clear();
+  rungs_[index].skip_edges.clear();
 }
 
 template <typename FloatType>
@@ -170,6 +206,50 @@ template <typename FloatType>
 void LadderGraph<FloatType>::clear()
 {
   rungs_.clear();
+  for (auto& arena : arenas_)
+    arena->reset();
+}
+
+template <typename FloatType>
+void LadderGraph<FloatType>::setUseArena(const bool use_arena)
+{
+  if (use_arena == use_arena_)
+    return;
+
+  // Edges allocated from the arenas must not outlive them
+  for (std::size_t i = 0; i < rungs_.size(); ++i)
+    clearEdges(i);
+
+  arenas_.clear();
+  use_arena_ = use_arena;
+}
+
+template <typename FloatType>
+bool LadderGraph<FloatType>::usesArena() const noexcept
+{
+  return use_arena_;
+}
+
+template <typename FloatType>
+void LadderGraph<FloatType>::resetArenas(const std::size_t n_threads)
+{
+  for (std::size_t i = 0; i < rungs_.size(); ++i)
+    clearEdges(i);
+
+  if (!use_arena_)
+    return;
+
+  for (auto& arena : arenas_)
+    arena->reset();
+
+  while (arenas_.size() < n_threads)
+    arenas_.emplace_back(new MonotonicArena());
+}
+
+template <typename FloatType>
+MonotonicArena* LadderGraph<FloatType>::arena(const std::size_t thread) const noexcept
+{
+  return thread < arenas_.size() ? arenas_[thread].get() : nullptr;
 }
 
 }  // namespace descartes_light
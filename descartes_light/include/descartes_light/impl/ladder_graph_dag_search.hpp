@@ -19,11 +19,19 @@
 #define DESCARTES_LIGHT_IMPL_LADDER_GRAPH_DAG_SEARCH_HPP
 
 #include "descartes_light/ladder_graph_dag_search.h"
+#include <functional>
+#include <limits>
+#include <queue>
+#include <tuple>
 
 namespace descartes_light
 {
 template <typename FloatType>
-DAGSearch<FloatType>::DAGSearch(const LadderGraph<FloatType>& graph) : graph_(graph)
+constexpr typename DAGSearch<FloatType>::predecessor_t DAGSearch<FloatType>::skipped_rung;
+
+template <typename FloatType>
+DAGSearch<FloatType>::DAGSearch(const LadderGraph<FloatType>& graph)
+  : graph_(graph), has_skip_edges_(graph.hasSkipEdges())
 {
   // On creating an object, let's allocate everything we need
   solution_.resize(graph.size());
@@ -33,14 +41,31 @@ DAGSearch<FloatType>::DAGSearch(const LadderGraph<FloatType>& graph) : graph_(gr
     const auto n_vertices = graph.rungSize(i);
     solution_[i].distance.resize(n_vertices);
     solution_[i].predecessor.resize(n_vertices);
+    if (has_skip_edges_)
+      solution_[i].predecessor_rung.resize(n_vertices);
   }
 }
 
 template <typename FloatType>
 FloatType DAGSearch<FloatType>::run()
 {
-  // Cost to the first rung should be set to zero
-  std::fill(solution_.front().distance.begin(), solution_.front().distance.end(), 0.0);
+  return run(std::vector<FloatType>(), std::vector<FloatType>());
+}
+
+template <typename FloatType>
+FloatType DAGSearch<FloatType>::run(const std::vector<FloatType>& initial_costs,
+                                    const std::vector<FloatType>& terminal_costs)
+{
+  assert(initial_costs.empty() || initial_costs.size() == solution_.front().distance.size());
+  assert(terminal_costs.empty() || terminal_costs.size() == solution_.back().distance.size());
+  initial_costs_ = initial_costs;
+  terminal_costs_ = terminal_costs;
+
+  // Cost to the first rung is the initial cost, zero unless provided
+  if (initial_costs_.empty())
+    std::fill(solution_.front().distance.begin(), solution_.front().distance.end(), 0.0);
+  else
+    solution_.front().distance = initial_costs_;
 
   // Other rows initialize to zero
   for (size_type i = 1; i < solution_.size(); ++i)
@@ -52,53 +77,477 @@ FloatType DAGSearch<FloatType>::run()
   for (size_type rung = 0; rung < solution_.size() - 1; ++rung)
   {
     const auto n_vertices = graph_.rungSize(rung);
-    const auto next_rung = rung + 1;
     // For each vertex in the out edge list
     for (size_t index = 0; index < n_vertices; ++index)
     {
       const auto u_cost = distance(rung, index);
-      const auto& edges = graph_.getEdges(rung)[index];
-      // for each out edge
-      for (const auto& edge : edges)
+      if (u_cost == std::numeric_limits<FloatType>::max())
+        continue;
+
+      relax(rung, index, u_cost);
+    }  // vertex for loop
+  }    // rung for loop
+
+  return bestLastVertex().first;
+}
+
+template <typename FloatType>
+void DAGSearch<FloatType>::relax(size_type rung, size_type index, FloatType u_cost)
+{
+  const auto next_rung = rung + 1;
+  // for each out edge
+  for (const auto& edge : graph_.getEdges(rung)[index])
+  {
+    auto dv = u_cost + edge.cost;  // new cost
+    if (dv < distance(next_rung, edge.idx))
+    {
+      distance(next_rung, edge.idx) = dv;
+      predecessor(next_rung, edge.idx) =
+          static_cast<unsigned>(index);  // the predecessor's rung is implied to be the current rung
+      if (has_skip_edges_)
+        solution_[next_rung].predecessor_rung[edge.idx] = static_cast<predecessor_t>(rung);
+    }
+  }
+
+  // for each out edge bypassing the next rung(s)
+  for (const auto& skip : graph_.getSkipEdges(rung))
+  {
+    for (const auto& edge : skip.edges[index])
+    {
+      auto dv = u_cost + edge.cost;
+      if (dv < distance(skip.to_rung, edge.idx))
       {
-        auto dv = u_cost + edge.cost;  // new cost
-        if (dv < distance(next_rung, edge.idx))
+        distance(skip.to_rung, edge.idx) = dv;
+        predecessor(skip.to_rung, edge.idx) = static_cast<predecessor_t>(index);
+        solution_[skip.to_rung].predecessor_rung[edge.idx] = static_cast<predecessor_t>(rung);
+      }
+    }
+  }
+}
+
+template <typename FloatType>
+FloatType DAGSearch<FloatType>::runLazy(const OutEdgesFn& out_edges,
+                                        const std::vector<FloatType>& initial_costs,
+                                        const std::vector<FloatType>& terminal_costs)
+{
+  assert(initial_costs.empty() || initial_costs.size() == solution_.front().distance.size());
+  assert(terminal_costs.empty() || terminal_costs.size() == solution_.back().distance.size());
+  initial_costs_ = initial_costs;
+  terminal_costs_ = terminal_costs;
+
+  const FloatType max_cost = std::numeric_limits<FloatType>::max();
+  const size_type last_rung = solution_.size() - 1;
+  for (auto& rung : solution_)
+    std::fill(rung.distance.begin(), rung.distance.end(), max_cost);
+
+  // Min-heap of (cost, rung, index); entries whose cost no longer matches the vertex distance are stale
+  using QueueEntry = std::tuple<FloatType, size_type, size_type>;
+  std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> queue;
+
+  for (size_type index = 0; index < solution_.front().distance.size(); ++index)
+  {
+    const FloatType cost = initial_costs_.empty() ? static_cast<FloatType>(0.0) : initial_costs_[index];
+    distance(0, index) = cost;
+    if (cost != max_cost)
+      queue.emplace(cost, 0, index);
+  }
+
+  const auto update = [this, &queue](size_type rung, size_type index, predecessor_t from_rung,
+                                     predecessor_t from_index, FloatType cost) {
+    if (cost < distance(rung, index))
+    {
+      distance(rung, index) = cost;
+      predecessor(rung, index) = from_index;
+      if (has_skip_edges_)
+        solution_[rung].predecessor_rung[index] = from_rung;
+      queue.emplace(cost, rung, index);
+    }
+  };
+
+  FloatType best = max_cost;
+  while (!queue.empty())
+  {
+    FloatType u_cost;
+    size_type rung, index;
+    std::tie(u_cost, rung, index) = queue.top();
+    queue.pop();
+
+    // Every vertex left costs at least as much to reach, and edge costs are non-negative
+    if (u_cost >= best)
+      break;
+
+    if (u_cost > distance(rung, index))
+      continue;
+
+    if (rung == last_rung)
+    {
+      if (terminal_costs_.empty())
+        best = u_cost;
+      else if (terminal_costs_[index] != max_cost)
+        best = std::min(best, u_cost + terminal_costs_[index]);
+      continue;
+    }
+
+    const auto from_rung = static_cast<predecessor_t>(rung);
+    const auto from_index = static_cast<predecessor_t>(index);
+    for (const auto& edge : out_edges(rung, index))
+      update(rung + 1, edge.idx, from_rung, from_index, u_cost + edge.cost);
+
+    for (const auto& skip : graph_.getSkipEdges(rung))
+      for (const auto& edge : skip.edges[index])
+        update(skip.to_rung, edge.idx, from_rung, from_index, u_cost + edge.cost);
+  }
+
+  return best;
+}
+
+template <typename FloatType>
+void DAGSearch<FloatType>::tracePath(size_type rung, size_type index, std::vector<predecessor_t>& path) const
+{
+  path[rung] = static_cast<predecessor_t>(index);
+  while (rung > 0)
+  {
+    const size_type prev_rung = has_skip_edges_ ? solution_[rung].predecessor_rung[path[rung]] : rung - 1;
+    const predecessor_t prev_index = predecessor(rung, path[rung]);
+    for (size_type r = prev_rung + 1; r < rung; ++r)
+      path[r] = skipped_rung;
+
+    rung = prev_rung;
+    path[rung] = prev_index;
+  }
+}
+
+template <typename FloatType>
+std::pair<FloatType, typename DAGSearch<FloatType>::size_type> DAGSearch<FloatType>::bestLastVertex() const
+{
+  const auto& last = solution_.back().distance;
+  std::pair<FloatType, size_type> best(std::numeric_limits<FloatType>::max(), 0);
+  for (size_type index = 0; index < last.size(); ++index)
+  {
+    const auto cost = last[index];
+    if (cost == std::numeric_limits<FloatType>::max())
+      continue;
+
+    const auto total = terminal_costs_.empty() ? cost : cost + terminal_costs_[index];
+    if (total < best.first)
+      best = { total, index };
+  }
+
+  return best;
+}
+
+template <typename FloatType>
+std::vector<typename DAGSearch<FloatType>::predecessor_t> DAGSearch<FloatType>::shortestPath() const
+{
+  std::vector<predecessor_t> path(solution_.size());
+  tracePath(path.size() - 1, bestLastVertex().second, path);
+  return path;
+}
+
+template <typename FloatType>
+FloatType DAGSearch<FloatType>::runBackward()
+{
+  for (auto& rung : solution_)
+  {
+    rung.cost_to_go.assign(rung.distance.size(), std::numeric_limits<FloatType>::max());
+    rung.successor.resize(rung.distance.size());
+    if (has_skip_edges_)
+      rung.successor_rung.resize(rung.distance.size());
+  }
+
+  // Cost from the last rung to the goal is the terminal cost, zero unless provided to run()
+  if (terminal_costs_.empty())
+    std::fill(solution_.back().cost_to_go.begin(), solution_.back().cost_to_go.end(), 0.0);
+  else
+    solution_.back().cost_to_go = terminal_costs_;
+
+  // Iterate over the graph in reverse 'topological' order
+  for (size_type rung = solution_.size() - 1; rung-- > 0;)
+  {
+    const auto n_vertices = graph_.rungSize(rung);
+    const auto next_rung = rung + 1;
+    const auto& rung_edges = graph_.getEdges(rung);
+    for (size_type index = 0; index < n_vertices && index < rung_edges.size(); ++index)
+    {
+      auto& best = costToGo(rung, index);
+      for (const auto& edge : rung_edges[index])
+      {
+        const auto v_cost = costToGo(next_rung, edge.idx);
+        if (v_cost == std::numeric_limits<FloatType>::max())
+          continue;
+
+        const auto du = v_cost + edge.cost;
+        if (du < best)
         {
-          distance(next_rung, edge.idx) = dv;
-          predecessor(next_rung, edge.idx) =
-              static_cast<unsigned>(index);  // the predecessor's rung is implied to be the current rung
+          best = du;
+          successor(rung, index) = edge.idx;  // the successor's rung is implied to be the next rung
+          if (has_skip_edges_)
+            solution_[rung].successor_rung[index] = static_cast<predecessor_t>(next_rung);
         }
       }
-    }  // vertex for loop
-  }    // rung for loop
 
-  return *std::min_element(solution_.back().distance.begin(), solution_.back().distance.end());
+      for (const auto& skip : graph_.getSkipEdges(rung))
+      {
+        for (const auto& edge : skip.edges[index])
+        {
+          const auto v_cost = costToGo(skip.to_rung, edge.idx);
+          if (v_cost == std::numeric_limits<FloatType>::max())
+            continue;
+
+          const auto du = v_cost + edge.cost;
+          if (du < best)
+          {
+            best = du;
+            successor(rung, index) = edge.idx;
+            solution_[rung].successor_rung[index] = static_cast<predecessor_t>(skip.to_rung);
+          }
+        }
+      }
+    }
+  }
+
+  FloatType best = std::numeric_limits<FloatType>::max();
+  for (size_type index = 0; index < solution_.front().cost_to_go.size(); ++index)
+  {
+    const auto cost = costToGo(0, index);
+    if (cost == std::numeric_limits<FloatType>::max())
+      continue;
+
+    if (initial_costs_.empty())
+      best = std::min(best, cost);
+    else if (initial_costs_[index] != std::numeric_limits<FloatType>::max())
+      best = std::min(best, cost + initial_costs_[index]);
+  }
+
+  return best;
 }
 
 template <typename FloatType>
-std::vector<typename DAGSearch<FloatType>::predecessor_t> DAGSearch<FloatType>::shortestPath() const
+FloatType DAGSearch<FloatType>::throughCost(size_type rung, size_type index) const noexcept
 {
-  auto min_it = std::min_element(solution_.back().distance.begin(), solution_.back().distance.end());
-  auto min_idx = std::distance(solution_.back().distance.begin(), min_it);
-  assert(min_idx >= 0);
+  const auto forward = distance(rung, index);
+  const auto backward = costToGo(rung, index);
+  if (forward == std::numeric_limits<FloatType>::max() || backward == std::numeric_limits<FloatType>::max())
+    return std::numeric_limits<FloatType>::max();
 
-  std::vector<predecessor_t> path(solution_.size());
+  return forward + backward;
+}
 
-  size_type current_rung = path.size() - 1;
-  size_type current_index = static_cast<size_type>(min_idx);
+template <typename FloatType>
+std::vector<typename DAGSearch<FloatType>::predecessor_t>
+DAGSearch<FloatType>::shortestPathThrough(size_type rung, size_type index) const
+{
+  assert(throughCost(rung, index) != std::numeric_limits<FloatType>::max());
+  std::vector<predecessor_t> path(solution_.size());
+  tracePath(rung, index, path);
 
-  for (unsigned i = 0; i < path.size(); ++i)
+  for (size_type r = rung; r + 1 < path.size();)
   {
-    auto count = path.size() - 1 - i;
-    assert(current_rung == count);
-    path[count] = static_cast<unsigned>(current_index);
-    current_index = predecessor(current_rung, current_index);
-    current_rung -= 1;
+    const size_type next_rung = has_skip_edges_ ? solution_[r].successor_rung[path[r]] : r + 1;
+    for (size_type skipped = r + 1; skipped < next_rung; ++skipped)
+      path[skipped] = skipped_rung;
+
+    path[next_rung] = successor(r, path[r]);
+    r = next_rung;
   }
 
   return path;
 }
 
+template <typename FloatType>
+std::vector<typename DAGSearch<FloatType>::size_type> DAGSearch<FloatType>::nearOptimalVertices(size_type rung,
+                                                                                               FloatType epsilon) const
+{
+  const auto optimum = bestLastVertex().first;
+
+  std::vector<size_type> vertices;
+  if (optimum == std::numeric_limits<FloatType>::max())
+    return vertices;
+
+  const FloatType bound = (static_cast<FloatType>(1.0) + epsilon) * optimum;
+  for (size_type index = 0; index < solution_[rung].distance.size(); ++index)
+  {
+    const auto cost = throughCost(rung, index);
+    if (cost != std::numeric_limits<FloatType>::max() && cost <= bound)
+      vertices.push_back(index);
+  }
+
+  return vertices;
+}
+
+template <typename FloatType>
+FloatType DAGSearch<FloatType>::runCyclic(const std::vector<typename LadderGraph<FloatType>::EdgeList>& closing_edges)
+{
+  const FloatType max_cost = std::numeric_limits<FloatType>::max();
+  const size_type last_rung = solution_.size() - 1;
+  const size_type n_start = solution_.front().distance.size();
+
+  initial_costs_.clear();
+  terminal_costs_.clear();
+  cycle_.clear();
+
+  // The cost to go to the last rung is shared by every start vertex
+  runBackward();
+
+  // Group the closing edges by the start vertex they return to
+  std::vector<std::vector<std::pair<size_type, FloatType>>> closing_into(n_start);
+  std::vector<FloatType> min_closing(n_start, max_cost);
+  for (size_type index = 0; index < closing_edges.size(); ++index)
+  {
+    for (const auto& edge : closing_edges[index])
+    {
+      closing_into[edge.idx].emplace_back(index, edge.cost);
+      min_closing[edge.idx] = std::min(min_closing[edge.idx], edge.cost);
+    }
+  }
+
+  // A lower bound on the cost of any cycle through each start vertex
+  std::vector<std::pair<FloatType, size_type>> order;
+  order.reserve(n_start);
+  for (size_type s = 0; s < n_start; ++s)
+  {
+    if (costToGo(0, s) != max_cost && min_closing[s] != max_cost)
+      order.emplace_back(costToGo(0, s) + min_closing[s], s);
+  }
+  std::sort(order.begin(), order.end());
+
+  FloatType best = max_cost;
+  for (const auto& candidate : order)
+  {
+    if (candidate.first >= best)
+      break;
+
+    const size_type start = candidate.second;
+    for (auto& rung : solution_)
+      std::fill(rung.distance.begin(), rung.distance.end(), max_cost);
+    distance(0, start) = 0.0;
+
+    // Single source sweep, pruning every vertex that cannot lead to a cheaper cycle
+    for (size_type rung = 0; rung < last_rung; ++rung)
+    {
+      const auto n_vertices = graph_.rungSize(rung);
+      for (size_type index = 0; index < n_vertices; ++index)
+      {
+        const auto u_cost = distance(rung, index);
+        if (u_cost == max_cost || costToGo(rung, index) == max_cost ||
+            u_cost + costToGo(rung, index) + min_closing[start] >= best)
+          continue;
+
+        relax(rung, index, u_cost);
+      }
+    }
+
+    // Close the loop
+    for (const auto& closing : closing_into[start])
+    {
+      const auto end_cost = distance(last_rung, closing.first);
+      if (end_cost == max_cost || end_cost + closing.second >= best)
+        continue;
+
+      best = end_cost + closing.second;
+      cycle_.resize(solution_.size());
+      tracePath(last_rung, closing.first, cycle_);
+    }
+  }
+
+  return best;
+}
+
+template <typename FloatType>
+std::vector<std::pair<typename DAGSearch<FloatType>::size_type, typename DAGSearch<FloatType>::size_type>>
+DAGSearch<FloatType>::findDisconnections(const LadderGraph<FloatType>& graph)
+{
+  std::vector<std::pair<size_type, size_type>> windows;
+  std::vector<char> current;
+  std::vector<char> next;
+
+  size_type start = 0;
+  while (start < graph.size())
+  {
+    if (graph.rungSize(start) == 0)
+    {
+      windows.emplace_back(start, start);
+      ++start;
+      continue;
+    }
+
+    // Forward sweep: which vertices can be reached from any vertex in 'start'
+    current.assign(graph.rungSize(start), 1);
+    size_type rung = start;
+    for (; rung + 1 < graph.size(); ++rung)
+    {
+      const auto n_next = graph.rungSize(rung + 1);
+      next.assign(n_next, 0);
+      size_type n_reached = 0;
+      const auto& edges = graph.getEdges(rung);
+      for (size_type index = 0; index < current.size() && n_reached < n_next; ++index)
+      {
+        if (!current[index] || index >= edges.size())
+          continue;
+
+        for (const auto& edge : edges[index])
+        {
+          if (!next[edge.idx])
+          {
+            next[edge.idx] = 1;
+            ++n_reached;
+          }
+        }
+      }
+
+      if (n_reached == 0)
+        break;
+
+      current.swap(next);
+    }
+
+    // The sweep made it to the end of the ladder
+    if (rung + 1 >= graph.size())
+      break;
+
+    const size_type last = rung + 1;
+    if (graph.rungSize(last) == 0)
+    {
+      windows.emplace_back(last, last);
+      start = last + 1;
+      continue;
+    }
+
+    // Backward sweep: which vertices can reach any vertex in 'last'. Every vertex in 'start' fails to do so, hence this
+    // always dies out at or after 'start'.
+    current.assign(graph.rungSize(last), 1);
+    size_type first = last - 1;
+    for (;; --first)
+    {
+      const auto& edges = graph.getEdges(first);
+      next.assign(graph.rungSize(first), 0);
+      bool any = false;
+      for (size_type index = 0; index < next.size() && index < edges.size(); ++index)
+      {
+        for (const auto& edge : edges[index])
+        {
+          if (current[edge.idx])
+          {
+            next[index] = 1;
+            any = true;
+            break;
+          }
+        }
+      }
+
+      if (!any || first == start)
+        break;
+
+      current.swap(next);
+    }
+
+    windows.emplace_back(first, last);
+    start = last;
+  }
+
+  return windows;
+}
+
 }  // namespace descartes_light
 
 #endif  // DESCARTES_LIGHT_IMPL_LADDER_GRAPH_DAG_SEARCH_HPP
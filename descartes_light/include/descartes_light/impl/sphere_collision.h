@@ -0,0 +1,178 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2016, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef DESCARTES_LIGHT_SPHERE_COLLISION_H
+#define DESCARTES_LIGHT_SPHERE_COLLISION_H
+
+#include <descartes_light/visibility_control.h>
+#include <descartes_light/interface/collision_interface.h>
+#include <descartes_light/interface/kinematics_interface.h>
+#include <Eigen/Geometry>
+#include <functional>
+#include <vector>
+
+namespace descartes_light
+{
+/**
+ * @brief A sphere of the robot model of a SphereCollision
+ */
+template <typename FloatType>
+struct CollisionSphere
+{
+  std::size_t link;                       /** @brief The link the sphere moves with, an index into the link poses */
+  Eigen::Matrix<FloatType, 3, 1> center;  /** @brief The center in the frame of the link */
+  FloatType radius;                       /** @brief Positive, see SphereCollision() */
+};
+
+/**
+ * @brief A coarse collision checker modelling the robot as spheres attached to its links and the environment as
+ * spheres and boxes
+ *
+ * It is meant as a cheap local backend: a first stage filter in front of an exact checker, or a reference to
+ * benchmark one against. The spheres should enclose the links; a state is then rejected whenever the links could
+ * touch the environment, and possibly when they do not.
+ *
+ * The link poses come from a LinkPosesFn. KinematicsInterface::fk() only provides the pose of the tool, so the
+ * constructor taking kinematics attaches every sphere to the tool, as link 0.
+ *
+ * The batched queries compute the robot spheres of all states first and then test them, in cache sized chunks, against
+ * each obstacle in turn. The validity kernels are loops over contiguous arrays that the compiler vectorizes; the
+ * distance kernels take a square root per pair and mostly do not. The single state queries are batches of one. The
+ * checker keeps its scratch buffers per thread, so an instance may be shared by several threads.
+ */
+template <typename FloatType>
+class SphereCollision : public CollisionInterface<FloatType>
+{
+public:
+  using Transform = Eigen::Transform<FloatType, 3, Eigen::Isometry>;
+  using TransformVector = std::vector<Transform, Eigen::aligned_allocator<Transform>>;
+  using Vector3 = Eigen::Matrix<FloatType, 3, 1>;
+
+  /**
+   * @brief Computes the poses of the links of a state in the frame of the environment
+   * @param link_poses Resized by the function, one pose per link
+   * @return False if the state has no such poses, which is then invalid
+   */
+  using LinkPosesFn = std::function<bool(const FloatType* pos, const std::size_t size, TransformVector& link_poses)>;
+
+  /**
+   * @param link_poses The link poses of a state
+   * @param spheres The spheres of the robot. A radius that is not positive is replaced by epsilon: with a radius of
+   * zero the validity kernels could not tell a sphere center on an obstacle from one clear of it, and validate() would
+   * disagree with distance().
+   * @param margin The clearance below which a state is invalid, at least zero
+   */
+  SphereCollision(LinkPosesFn link_poses, std::vector<CollisionSphere<FloatType>> spheres, FloatType margin = 0);
+
+  /**
+   * @brief Attaches every sphere to the tool pose given by kinematics->fk(), whatever its link
+   */
+  SphereCollision(typename KinematicsInterface<FloatType>::ConstPtr kinematics,
+                  std::vector<CollisionSphere<FloatType>> spheres,
+                  FloatType margin = 0);
+
+  /** @brief Adds a spherical obstacle, a negative radius counts as zero */
+  void addSphere(const Vector3& center, const FloatType radius);
+
+  /** @brief Adds a box shaped obstacle, centered on 'pose' and extending 'half_extents' along its axes */
+  void addBox(const Transform& pose, const Vector3& half_extents);
+
+  /** @brief Removes every obstacle */
+  void clearEnvironment();
+
+  /** @brief True if no robot sphere is within the margin of an obstacle: distance() >= margin, up to rounding */
+  bool validate(const FloatType* pos, const std::size_t size) override;
+
+  /**
+   * @brief The smallest signed distance between a robot sphere and an obstacle, negative when they overlap. The
+   * largest FloatType without obstacles and the lowest if the link poses of the state are unknown.
+   */
+  FloatType distance(const FloatType* pos, const std::size_t size) override;
+
+  std::size_t validateBatch(const FloatType* pos, const std::size_t size, const std::size_t n, char* valid) override;
+
+  void distanceBatch(const FloatType* pos, const std::size_t size, const std::size_t n, FloatType* distances) override;
+
+  std::shared_ptr<CollisionInterface<FloatType>> clone() const override;
+
+private:
+  /** @brief An obstacle box, stored as the transform from the environment into the frame of the box */
+  struct Box
+  {
+    Eigen::Matrix<FloatType, 3, 3> rotation;
+    Vector3 translation;
+    Vector3 half_extents;
+  };
+
+  struct Sphere
+  {
+    Vector3 center;
+    FloatType radius;
+  };
+
+  /** @brief The robot spheres of a batch of states, one array per coordinate */
+  struct SphereArrays
+  {
+    std::vector<FloatType> x;
+    std::vector<FloatType> y;
+    std::vector<FloatType> z;
+    std::vector<FloatType> radius;
+    std::vector<char> posed;  /** @brief Per state, whether its link poses are known */
+  };
+
+  /** @brief Fills 'spheres' with the robot spheres of n states, spheres_.size() per state */
+  void placeSpheres(const FloatType* pos, const std::size_t size, const std::size_t n, SphereArrays& spheres) const;
+
+  /**
+   * @brief Lowers 'excess' to the squared clearance of each robot sphere minus its squared margin, where smaller.
+   * Negative excess is a collision.
+   */
+  void sphereExcess(const SphereArrays& spheres, FloatType* excess) const;
+
+  /** @brief Lowers 'distances' to the signed distance of each robot sphere to the obstacles, where smaller */
+  void sphereDistances(const SphereArrays& spheres, FloatType* distances) const;
+
+  /** @brief The kernels of sphereExcess() and sphereDistances() for a chunk of 'n' robot spheres */
+  void sphereExcess(const FloatType* x,
+                    const FloatType* y,
+                    const FloatType* z,
+                    const FloatType* r,
+                    const std::size_t n,
+                    FloatType* excess) const;
+
+  void sphereDistances(const FloatType* x,
+                       const FloatType* y,
+                       const FloatType* z,
+                       const FloatType* r,
+                       const std::size_t n,
+                       FloatType* distances) const;
+
+  /** @brief The number of robot spheres tested against all obstacles at once, their arrays fit in the L1 cache */
+  static constexpr std::size_t chunk_size = 512;
+
+  LinkPosesFn link_poses_;
+  std::vector<CollisionSphere<FloatType>> spheres_;
+  FloatType margin_;
+  std::vector<Sphere> obstacle_spheres_;
+  std::vector<Box> obstacle_boxes_;
+};
+
+using SphereCollisionD = SphereCollision<double>;
+using SphereCollisionF = SphereCollision<float>;
+}  // namespace descartes_light
+
+#endif  // DESCARTES_LIGHT_SPHERE_COLLISION_H
@@ -0,0 +1,342 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2016, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef DESCARTES_LIGHT_SPHERE_COLLISION_HPP
+#define DESCARTES_LIGHT_SPHERE_COLLISION_HPP
+
+#include <descartes_light/impl/sphere_collision.h>
+#include <console_bridge/console.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace descartes_light
+{
+template <typename FloatType>
+SphereCollision<FloatType>::SphereCollision(LinkPosesFn link_poses,
+                                            std::vector<CollisionSphere<FloatType>> spheres,
+                                            FloatType margin)
+  : link_poses_(std::move(link_poses)), spheres_(std::move(spheres)), margin_(std::max<FloatType>(margin, 0))
+{
+  for (auto& sphere : spheres_)
+  {
+    if (!(sphere.radius > 0))
+    {
+      CONSOLE_BRIDGE_logError("SphereCollision needs spheres of positive radius, using epsilon instead of %f",
+                              static_cast<double>(sphere.radius));
+      sphere.radius = std::numeric_limits<FloatType>::epsilon();
+    }
+  }
+}
+
+template <typename FloatType>
+SphereCollision<FloatType>::SphereCollision(typename KinematicsInterface<FloatType>::ConstPtr kinematics,
+                                            std::vector<CollisionSphere<FloatType>> spheres,
+                                            FloatType margin)
+  : SphereCollision(
+        [kinematics](const FloatType* pos, const std::size_t /*size*/, TransformVector& link_poses) {
+          link_poses.resize(1);
+          return kinematics->fk(pos, link_poses[0]);
+        },
+        std::move(spheres),
+        margin)
+{
+  for (auto& sphere : spheres_)
+    sphere.link = 0;
+}
+
+template <typename FloatType>
+void SphereCollision<FloatType>::addSphere(const Vector3& center, const FloatType radius)
+{
+  Sphere sphere;
+  sphere.center = center;
+  sphere.radius = std::max<FloatType>(radius, 0);
+  obstacle_spheres_.push_back(sphere);
+}
+
+template <typename FloatType>
+void SphereCollision<FloatType>::addBox(const Transform& pose, const Vector3& half_extents)
+{
+  const Transform inverse = pose.inverse();
+  Box box;
+  box.rotation = inverse.linear();
+  box.translation = inverse.translation();
+  box.half_extents = half_extents.cwiseAbs();
+  obstacle_boxes_.push_back(box);
+}
+
+template <typename FloatType>
+void SphereCollision<FloatType>::clearEnvironment()
+{
+  obstacle_spheres_.clear();
+  obstacle_boxes_.clear();
+}
+
+template <typename FloatType>
+bool SphereCollision<FloatType>::validate(const FloatType* pos, const std::size_t size)
+{
+  char valid;
+  validateBatch(pos, size, 1, &valid);
+  return valid != 0;
+}
+
+template <typename FloatType>
+FloatType SphereCollision<FloatType>::distance(const FloatType* pos, const std::size_t size)
+{
+  FloatType distance;
+  distanceBatch(pos, size, 1, &distance);
+  return distance;
+}
+
+template <typename FloatType>
+std::size_t SphereCollision<FloatType>::validateBatch(const FloatType* pos,
+                                                      const std::size_t size,
+                                                      const std::size_t n,
+                                                      char* valid)
+{
+  thread_local SphereArrays spheres;
+  thread_local std::vector<FloatType> excess;
+  placeSpheres(pos, size, n, spheres);
+  excess.assign(spheres.x.size(), std::numeric_limits<FloatType>::max());
+  sphereExcess(spheres, excess.data());
+
+  const std::size_t m = spheres_.size();
+  std::size_t n_valid = 0;
+  for (std::size_t s = 0; s < n; ++s)
+  {
+    const auto first = excess.begin() + static_cast<std::ptrdiff_t>(s * m);
+    const bool free = spheres.posed[s] && std::none_of(first, first + static_cast<std::ptrdiff_t>(m), [](FloatType e) {
+                        return e < 0;
+                      });
+    valid[s] = free ? 1 : 0;
+    n_valid += free ? 1 : 0;
+  }
+  return n_valid;
+}
+
+template <typename FloatType>
+void SphereCollision<FloatType>::distanceBatch(const FloatType* pos,
+                                               const std::size_t size,
+                                               const std::size_t n,
+                                               FloatType* distances)
+{
+  thread_local SphereArrays spheres;
+  thread_local std::vector<FloatType> sphere_distances;
+  placeSpheres(pos, size, n, spheres);
+  sphere_distances.assign(spheres.x.size(), std::numeric_limits<FloatType>::max());
+  sphereDistances(spheres, sphere_distances.data());
+
+  const std::size_t m = spheres_.size();
+  for (std::size_t s = 0; s < n; ++s)
+  {
+    if (!spheres.posed[s])
+    {
+      distances[s] = std::numeric_limits<FloatType>::lowest();
+      continue;
+    }
+
+    const auto first = sphere_distances.begin() + static_cast<std::ptrdiff_t>(s * m);
+    distances[s] = std::accumulate(first,
+                                   first + static_cast<std::ptrdiff_t>(m),
+                                   std::numeric_limits<FloatType>::max(),
+                                   [](FloatType a, FloatType b) { return std::min(a, b); });
+  }
+}
+
+template <typename FloatType>
+std::shared_ptr<CollisionInterface<FloatType>> SphereCollision<FloatType>::clone() const
+{
+  return std::make_shared<SphereCollision<FloatType>>(*this);
+}
+
+template <typename FloatType>
+void SphereCollision<FloatType>::placeSpheres(const FloatType* pos,
+                                              const std::size_t size,
+                                              const std::size_t n,
+                                              SphereArrays& spheres) const
+{
+  const std::size_t m = spheres_.size();
+  spheres.x.resize(n * m);
+  spheres.y.resize(n * m);
+  spheres.z.resize(n * m);
+  spheres.radius.resize(n * m);
+  spheres.posed.resize(n);
+
+  thread_local TransformVector link_poses;
+  for (std::size_t s = 0; s < n; ++s)
+  {
+    bool posed = link_poses_(pos + s * size, size, link_poses);
+    for (std::size_t k = 0; k < m && posed; ++k)
+    {
+      const CollisionSphere<FloatType>& sphere = spheres_[k];
+      if (sphere.link >= link_poses.size())
+      {
+        posed = false;
+        break;
+      }
+
+      const Vector3 center = link_poses[sphere.link] * sphere.center;
+      spheres.x[s * m + k] = center.x();
+      spheres.y[s * m + k] = center.y();
+      spheres.z[s * m + k] = center.z();
+      spheres.radius[s * m + k] = sphere.radius;
+    }
+
+    // The result of a state without poses is overridden, its spheres only need defined values
+    if (!posed)
+    {
+      const auto first = static_cast<std::ptrdiff_t>(s * m);
+      std::fill_n(spheres.x.begin() + first, m, FloatType(0));
+      std::fill_n(spheres.y.begin() + first, m, FloatType(0));
+      std::fill_n(spheres.z.begin() + first, m, FloatType(0));
+      std::fill_n(spheres.radius.begin() + first, m, FloatType(0));
+    }
+    spheres.posed[s] = posed ? 1 : 0;
+  }
+}
+
+template <typename FloatType>
+void SphereCollision<FloatType>::sphereExcess(const SphereArrays& spheres, FloatType* excess) const
+{
+  // Chunks of robot spheres small enough to stay in cache while every obstacle is tested against them
+  for (std::size_t begin = 0; begin < spheres.x.size(); begin += chunk_size)
+  {
+    const std::size_t n = std::min(chunk_size, spheres.x.size() - begin);
+    sphereExcess(spheres.x.data() + begin,
+                 spheres.y.data() + begin,
+                 spheres.z.data() + begin,
+                 spheres.radius.data() + begin,
+                 n,
+                 excess + begin);
+  }
+}
+
+template <typename FloatType>
+void SphereCollision<FloatType>::sphereExcess(const FloatType* x,
+                                              const FloatType* y,
+                                              const FloatType* z,
+                                              const FloatType* r,
+                                              const std::size_t n,
+                                              FloatType* excess) const
+{
+  // One obstacle at a time against every robot sphere: the inner loops run over contiguous arrays and vectorize
+  for (const Sphere& obstacle : obstacle_spheres_)
+  {
+    const FloatType ox = obstacle.center.x();
+    const FloatType oy = obstacle.center.y();
+    const FloatType oz = obstacle.center.z();
+    const FloatType reach = obstacle.radius + margin_;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      const FloatType dx = x[i] - ox;
+      const FloatType dy = y[i] - oy;
+      const FloatType dz = z[i] - oz;
+      const FloatType limit = r[i] + reach;
+      excess[i] = std::min(excess[i], dx * dx + dy * dy + dz * dz - limit * limit);
+    }
+  }
+
+  for (const Box& box : obstacle_boxes_)
+  {
+    const Eigen::Matrix<FloatType, 3, 3>& rot = box.rotation;
+    const FloatType r00 = rot(0, 0), r01 = rot(0, 1), r02 = rot(0, 2);
+    const FloatType r10 = rot(1, 0), r11 = rot(1, 1), r12 = rot(1, 2);
+    const FloatType r20 = rot(2, 0), r21 = rot(2, 1), r22 = rot(2, 2);
+    const FloatType tx = box.translation.x(), ty = box.translation.y(), tz = box.translation.z();
+    const FloatType hx = box.half_extents.x(), hy = box.half_extents.y(), hz = box.half_extents.z();
+    const FloatType margin = margin_;
+    const FloatType half = static_cast<FloatType>(0.5);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      // The distance from the center of the sphere to the box, zero inside it. (a + |a|) / 2 is max(a, 0) in a form
+      // GCC vectorizes without -fno-trapping-math.
+      const FloatType ax = std::abs(r00 * x[i] + r01 * y[i] + r02 * z[i] + tx) - hx;
+      const FloatType ay = std::abs(r10 * x[i] + r11 * y[i] + r12 * z[i] + ty) - hy;
+      const FloatType az = std::abs(r20 * x[i] + r21 * y[i] + r22 * z[i] + tz) - hz;
+      const FloatType qx = half * (ax + std::abs(ax));
+      const FloatType qy = half * (ay + std::abs(ay));
+      const FloatType qz = half * (az + std::abs(az));
+      const FloatType limit = r[i] + margin;
+      excess[i] = std::min(excess[i], qx * qx + qy * qy + qz * qz - limit * limit);
+    }
+  }
+}
+
+template <typename FloatType>
+void SphereCollision<FloatType>::sphereDistances(const SphereArrays& spheres, FloatType* distances) const
+{
+  for (std::size_t begin = 0; begin < spheres.x.size(); begin += chunk_size)
+  {
+    const std::size_t n = std::min(chunk_size, spheres.x.size() - begin);
+    sphereDistances(spheres.x.data() + begin,
+                    spheres.y.data() + begin,
+                    spheres.z.data() + begin,
+                    spheres.radius.data() + begin,
+                    n,
+                    distances + begin);
+  }
+}
+
+template <typename FloatType>
+void SphereCollision<FloatType>::sphereDistances(const FloatType* x,
+                                                 const FloatType* y,
+                                                 const FloatType* z,
+                                                 const FloatType* r,
+                                                 const std::size_t n,
+                                                 FloatType* distances) const
+{
+  for (const Sphere& obstacle : obstacle_spheres_)
+  {
+    const FloatType ox = obstacle.center.x();
+    const FloatType oy = obstacle.center.y();
+    const FloatType oz = obstacle.center.z();
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      const FloatType dx = x[i] - ox;
+      const FloatType dy = y[i] - oy;
+      const FloatType dz = z[i] - oz;
+      distances[i] = std::min(distances[i], std::sqrt(dx * dx + dy * dy + dz * dz) - r[i] - obstacle.radius);
+    }
+  }
+
+  for (const Box& box : obstacle_boxes_)
+  {
+    const Eigen::Matrix<FloatType, 3, 3>& rot = box.rotation;
+    const FloatType r00 = rot(0, 0), r01 = rot(0, 1), r02 = rot(0, 2);
+    const FloatType r10 = rot(1, 0), r11 = rot(1, 1), r12 = rot(1, 2);
+    const FloatType r20 = rot(2, 0), r21 = rot(2, 1), r22 = rot(2, 2);
+    const FloatType tx = box.translation.x(), ty = box.translation.y(), tz = box.translation.z();
+    const FloatType hx = box.half_extents.x(), hy = box.half_extents.y(), hz = box.half_extents.z();
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      // Signed distance from the center of the sphere to the box, negative inside it
+      const FloatType ax = std::abs(r00 * x[i] + r01 * y[i] + r02 * z[i] + tx) - hx;
+      const FloatType ay = std::abs(r10 * x[i] + r11 * y[i] + r12 * z[i] + ty) - hy;
+      const FloatType az = std::abs(r20 * x[i] + r21 * y[i] + r22 * z[i] + tz) - hz;
+      const FloatType qx = std::max(ax, FloatType(0));
+      const FloatType qy = std::max(ay, FloatType(0));
+      const FloatType qz = std::max(az, FloatType(0));
+      const FloatType inside = std::min(std::max(ax, std::max(ay, az)), FloatType(0));
+      distances[i] = std::min(distances[i], std::sqrt(qx * qx + qy * qy + qz * qz) + inside - r[i]);
+    }
+  }
+}
+
+}  // namespace descartes_light
+
+#endif  // DESCARTES_LIGHT_SPHERE_COLLISION_HPP
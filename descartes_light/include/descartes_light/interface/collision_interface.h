@@ -19,7 +19,9 @@
 #define DESCARTES_LIGHT_CORE_COLLISION_INTERFACE_H
 
 #include <descartes_light/visibility_control.h>
+#include <algorithm>
 #include <memory>
+#include <vector>
 
 namespace descartes_light
 {
@@ -33,6 +35,37 @@ public:
 
   virtual FloatType distance(const FloatType* pos, const std::size_t size) = 0;
 
+  /**
+   * @brief Validates n states stored one after the other, 'size' values each
+   *
+   * The default calls validate() for each state. Override it when the collision backend checks a block of states
+   * faster than one at a time, e.g. by updating its broadphase once for the whole block.
+   * @param valid Set to 1 for each valid state and 0 for the others, n entries
+   * @return The number of valid states
+   */
+  virtual std::size_t validateBatch(const FloatType* pos, const std::size_t size, const std::size_t n, char* valid)
+  {
+    std::size_t n_valid = 0;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      valid[i] = validate(pos + i * size, size) ? 1 : 0;
+      n_valid += static_cast<std::size_t>(valid[i]);
+    }
+    return n_valid;
+  }
+
+  /**
+   * @brief Computes the distances of n states stored one after the other, 'size' values each
+   *
+   * The default calls distance() for each state.
+   * @param distances Set to the distance of each state, n entries
+   */
+  virtual void distanceBatch(const FloatType* pos, const std::size_t size, const std::size_t n, FloatType* distances)
+  {
+    for (std::size_t i = 0; i < n; ++i)
+      distances[i] = distance(pos + i * size, size);
+  }
+
   /** You assume ownership of return value */
   virtual std::shared_ptr<CollisionInterface> clone() const = 0;
 
@@ -43,6 +76,53 @@ public:
 using CollisionInterfaceF = CollisionInterface<float>;
 using CollisionInterfaceD = CollisionInterface<double>;
 
+/**
+ * @brief Appends the valid states among n states stored one after the other, checked in a single validateBatch() call
+ *
+ * Without a collision interface every state is appended. If no state is valid, 'solution_set' is still empty and
+ * 'allow_collision' is set, the state of greatest distance is appended instead.
+ * @return True if any state was appended
+ */
+template <typename FloatType>
+inline bool appendCollisionFree(CollisionInterface<FloatType>* collision,
+                                const FloatType* states,
+                                const std::size_t size,
+                                const std::size_t n,
+                                const bool allow_collision,
+                                std::vector<FloatType>& solution_set)
+{
+  if (collision == nullptr)
+  {
+    solution_set.insert(solution_set.end(), states, states + n * size);
+    return n != 0;
+  }
+
+  thread_local std::vector<char> valid;
+  valid.resize(n);
+  const std::size_t n_valid = collision->validateBatch(states, size, n, valid.data());
+
+  if (n_valid == 0)
+  {
+    if (!allow_collision || n == 0 || !solution_set.empty())
+      return false;
+
+    // Keep the least colliding state
+    thread_local std::vector<FloatType> distances;
+    distances.resize(n);
+    collision->distanceBatch(states, size, n, distances.data());
+    const auto best =
+        static_cast<std::size_t>(std::max_element(distances.begin(), distances.end()) - distances.begin());
+    solution_set.insert(solution_set.end(), states + best * size, states + (best + 1) * size);
+    return true;
+  }
+
+  solution_set.reserve(solution_set.size() + n_valid * size);
+  for (std::size_t i = 0; i < n; ++i)
+    if (valid[i])
+      solution_set.insert(solution_set.end(), states + i * size, states + (i + 1) * size);
+  return true;
+}
+
 }  // namespace descartes_light
 
 #endif  // DESCARTES_LIGHT_CORE_COLLISION_INTERFACE_H
@@ -34,6 +34,30 @@ public:
                         const Rung_<FloatType>& to,
                         std::vector<typename LadderGraph<FloatType>::EdgeList>& edges) = 0;
 
+  /**
+   * @brief A copy for the exclusive use of one worker thread, see ThreadClones
+   *
+   * The default returns nullptr, declaring evaluate() safe to call from several threads at once. Override it if it
+   * modifies state.
+   */
+  virtual std::shared_ptr<EdgeEvaluator> clone() const { return nullptr; }
+
+  /**
+   * @brief Whether evaluate() leaves some checks of its edges to isValid()
+   *
+   * The solver then calls isValid() on the edges of each path it finds, removes those that fail from the graph and
+   * searches again, see Solver::search(). The default returns false.
+   */
+  virtual bool hasDeferredChecks() const { return false; }
+
+  /**
+   * @brief The deferred checks of the edge between two vertices, see hasDeferredChecks()
+   * @param from The joint values of the start vertex, 'dof' values
+   * @param to The joint values of the end vertex, 'dof' values
+   * @return True if the edge is feasible. The default accepts every edge.
+   */
+  virtual bool isValid(const FloatType* /*from*/, const FloatType* /*to*/, const std::size_t /*dof*/) { return true; }
+
   typedef typename std::shared_ptr<EdgeEvaluator<FloatType>> Ptr;
 };
 
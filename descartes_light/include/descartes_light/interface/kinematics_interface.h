@@ -33,12 +33,54 @@ public:
 
   virtual bool ik(const Eigen::Transform<FloatType, 3, Eigen::Isometry>& p,
                   std::vector<FloatType>& solution_set) const = 0;
+
+  /**
+   * @brief Solves the inverse kinematics of a batch of poses
+   *
+   * The default implementation calls ik() once per pose. Implementations override it to share per-call setup, such as
+   * inverting the base and tool transforms, across the batch.
+   *
+   * @param poses The 'n' poses to solve
+   * @param n The number of poses
+   * @param solution_set The solutions of every pose are appended here, 'dof' values per solution
+   * @param offsets Resized to n + 1 such that the solutions of pose i are solution_set[offsets[i], offsets[i + 1])
+   * @return True if a solution was found for any of the poses
+   */
+  virtual bool ik(const Eigen::Transform<FloatType, 3, Eigen::Isometry>* poses,
+                  const std::size_t n,
+                  std::vector<FloatType>& solution_set,
+                  std::vector<std::size_t>& offsets) const
+  {
+    offsets.resize(n + 1);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      offsets[i] = solution_set.size();
+      ik(poses[i], solution_set);
+    }
+    offsets[n] = solution_set.size();
+
+    return offsets[n] != offsets[0];
+  }
+
   virtual bool fk(const FloatType* pose, Eigen::Transform<FloatType, 3, Eigen::Isometry>& solution) const = 0;
 
   virtual int dof() const = 0;
 
   virtual void analyzeIK(const Eigen::Transform<FloatType, 3, Eigen::Isometry>& p) const = 0;
 
+  /**
+   * @brief A copy for the exclusive use of one worker thread, see ThreadClones
+   *
+   * The default returns nullptr, declaring ik() and fk() safe to call from several threads at once. Override it if they
+   * modify state.
+   */
+  virtual std::shared_ptr<KinematicsInterface> clone() const { return nullptr; }
+
+  /** @brief A contiguous batch of poses, see the batched ik() */
+  typedef std::vector<Eigen::Transform<FloatType, 3, Eigen::Isometry>,
+                      Eigen::aligned_allocator<Eigen::Transform<FloatType, 3, Eigen::Isometry>>>
+      PoseVector;
+
   typedef typename std::shared_ptr<KinematicsInterface> Ptr;
   typedef typename std::shared_ptr<const KinematicsInterface> ConstPtr;
 };
@@ -30,8 +30,29 @@ class PositionSampler
 public:
   virtual ~PositionSampler() {}
 
+  /**
+   * @brief Appends the joint solutions of the waypoint to 'solution_set'
+   *
+   * Solver::build() passes the vertex storage of the rung itself, emptied but keeping its capacity from the previous
+   * build, so implementations should append to it rather than build a local result and copy or swap it in.
+   * @return True if at least one solution was found
+   */
   virtual bool sample(std::vector<FloatType>& solution_set) = 0;
 
+  /**
+   * @brief Appends the joint solutions of the waypoint like sample(), but without checking them for collision
+   *
+   * Used by Solver::setLazyCollisionChecking(), which only checks the vertices of candidate paths, with isValid(). The
+   * default calls sample(), whose solutions are all checked already.
+   */
+  virtual bool sampleUnchecked(std::vector<FloatType>& solution_set) { return sample(solution_set); }
+
+  /**
+   * @brief Checks a solution returned by sampleUnchecked() for collision
+   * @return True if sample() would have kept the solution. The default accepts every solution.
+   */
+  virtual bool isValid(const FloatType* /*vertex*/) { return true; }
+
   typedef typename std::shared_ptr<PositionSampler<FloatType>> Ptr;
 };
 
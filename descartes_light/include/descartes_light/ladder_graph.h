@@ -19,8 +19,10 @@
 #define DESCARTES_LIGHT_LADDER_GRAPH_H
 
 #include <descartes_light/visibility_control.h>
+#include <descartes_light/arena.h>
 #include <algorithm>
 #include <cassert>
+#include <memory>
 #include <vector>
 
 namespace descartes_core
@@ -51,16 +53,31 @@ struct Edge_
   unsigned idx; /** @brief from THIS rung to 'idx' into the NEXT rung */
 };
 
+/** @brief The out edges of a vertex, allocated from the arena of the graph when it has one, see ArenaAllocator */
+template <typename FloatType>
+using EdgeList_ = std::vector<Edge_<FloatType>, ArenaAllocator<Edge_<FloatType>>>;
+
+template <typename FloatType>
+struct SkipEdges_
+{
+  using EdgeList = EdgeList_<FloatType>;
+
+  std::size_t to_rung;          /** @brief the rung these edges lead into, at least two rungs after their owner */
+  std::vector<EdgeList> edges;  /** @brief one out edge list per vertex of the rung who owns this object */
+};
+
 template <typename FloatType>
 struct Rung_
 {
   using Edge = Edge_<FloatType>;
-  using EdgeList = std::vector<Edge>;
+  using EdgeList = EdgeList_<FloatType>;
+  using SkipEdges = SkipEdges_<FloatType>;
 
   descartes_core::TrajectoryID id;                     // corresponds to user's input ID
   descartes_core::TimingConstraint<FloatType> timing;  // user input timing
   std::vector<FloatType> data;                         // joint values stored in one contiguous array
   std::vector<EdgeList> edges;
+  std::vector<SkipEdges> skip_edges;  // edges bypassing the next rung(s), usually empty
 };
 
 /**
@@ -74,6 +91,7 @@ class LadderGraph
 public:
   using Rung = Rung_<FloatType>;
   using EdgeList = typename Rung::EdgeList;
+  using SkipEdges = typename Rung::SkipEdges;
 
   /**
    * @brief LadderGraph
@@ -81,6 +99,13 @@ public:
    */
   explicit LadderGraph(const std::size_t dof) noexcept;
 
+  /**
+   * @brief Copies the rungs; the copy allocates its edges from the heap, even within an ArenaScope, so it stays valid
+   * when the arenas of either graph are reset
+   */
+  LadderGraph(const LadderGraph& other);
+  LadderGraph(LadderGraph&& other) = default;
+
   /**
    * @brief resize Resizes the internal ladder to have 'n_rung' rungs
    * @param n_rungs Number of individual rungs
@@ -93,6 +118,17 @@ public:
   std::vector<EdgeList>& getEdges(const std::size_t index) noexcept;  // see p.23 Effective C++ (Scott Meyers)
   const std::vector<EdgeList>& getEdges(const std::size_t index) const noexcept;
 
+  /**
+   * @brief getSkipEdges The edges leaving rung 'index' that bypass one or more of the following rungs
+   */
+  std::vector<SkipEdges>& getSkipEdges(const std::size_t index) noexcept;
+  const std::vector<SkipEdges>& getSkipEdges(const std::size_t index) const noexcept;
+
+  /**
+   * @brief hasSkipEdges tests to see if any rung has edges that bypass other rungs
+   */
+  bool hasSkipEdges() const noexcept;
+
   std::size_t rungSize(const std::size_t index) const noexcept;
 
   /**
@@ -168,9 +204,35 @@ public:
    */
   void clear();
 
+  /**
+   * @brief Allocates the edges of the graph from monotonic arenas owned by the graph, one per building thread
+   *
+   * Edges are then released without calls to free and their memory is reused by the next build. Edge lists are only
+   * allocated from an arena within an ArenaScope, see arena(); Solver::build() sets one up per thread.
+   */
+  void setUseArena(const bool use_arena);
+
+  bool usesArena() const noexcept;
+
+  /**
+   * @brief Drops the edges of every rung and rewinds the arenas, making sure there is one per thread of the coming
+   *        build. Without arenas, only drops the edges.
+   */
+  void resetArenas(const std::size_t n_threads);
+
+  /**
+   * @brief The arena for thread 'thread' of a parallel build, or nullptr if the graph does not use arenas
+   */
+  MonotonicArena* arena(const std::size_t thread) const noexcept;
+
 private:
   const std::size_t dof_;
+  bool use_arena_;
+  std::vector<std::unique_ptr<MonotonicArena>> arenas_;  // declared before the rungs, whose edges they hold
   std::vector<Rung> rungs_;
+
+  /** @brief A copy of 'rungs' whose edges are allocated from the heap, whatever the current arena */
+  static std::vector<Rung> heapCopy(const std::vector<Rung>& rungs);
 };
 
 using LadderGraphF = LadderGraph<float>;
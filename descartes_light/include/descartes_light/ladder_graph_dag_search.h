@@ -20,6 +20,10 @@
 #define DESCARTES_LIGHT_LADDER_GRAPH_DAG_SEARCH_H
 
 #include "descartes_light/ladder_graph.h"
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
 
 namespace descartes_light
 {
@@ -30,23 +34,152 @@ public:
   using predecessor_t = unsigned;
   using size_type = std::size_t;
 
+  /** @brief Marks, in a returned path, a rung that is bypassed by a skip edge */
+  static constexpr predecessor_t skipped_rung = std::numeric_limits<predecessor_t>::max();
+
+  /** @brief Returns the out edges of vertex 'index' of rung 'rung', see runLazy() */
+  using OutEdgesFn = std::function<const typename LadderGraph<FloatType>::EdgeList&(size_type rung, size_type index)>;
+
   explicit DAGSearch(const LadderGraph<FloatType>& graph);
 
   FloatType run();
 
+  /**
+   * @brief run Searches the graph with the given cost of starting at each vertex of the first rung and of ending at
+   * each vertex of the last rung. A cost of std::numeric_limits<FloatType>::max() excludes the vertex.
+   * @param initial_costs One cost per vertex of the first rung, or empty for zero costs
+   * @param terminal_costs One cost per vertex of the last rung, or empty for zero costs
+   * @return The cost of the shortest path, including its initial and terminal costs
+   */
+  FloatType run(const std::vector<FloatType>& initial_costs, const std::vector<FloatType>& terminal_costs);
+
+  /**
+   * @brief runLazy Searches the graph best-first, asking for the out edges of a vertex only when it is expanded
+   *
+   * Vertices are expanded in increasing order of their cost from the first rung, and the search stops once no vertex
+   * left can lead to a cheaper path than the best one found. Vertices that cost more to reach than the shortest path
+   * are never expanded, so 'out_edges' is never called for them. Skip edges are taken from the graph.
+   *
+   * Requires non-negative edge and terminal costs. Finds a path of the same cost as run(), and shortestPath() is
+   * valid afterwards; runBackward() is not, as it reads every edge of the graph.
+   *
+   * @param out_edges Returns the out edges of a vertex; the graph's own edges of unexpanded vertices are not read
+   * @param initial_costs One cost per vertex of the first rung, or empty for zero costs
+   * @param terminal_costs One cost per vertex of the last rung, or empty for zero costs
+   * @return The cost of the shortest path, including its initial and terminal costs
+   */
+  FloatType runLazy(const OutEdgesFn& out_edges,
+                    const std::vector<FloatType>& initial_costs,
+                    const std::vector<FloatType>& terminal_costs);
+
+  /**
+   * @brief shortestPath The vertex index per rung of the path found by run(). Rungs bypassed by skip edges, see
+   * LadderGraph::getSkipEdges(), are marked with 'skipped_rung'.
+   */
   std::vector<predecessor_t> shortestPath() const;
 
+  /**
+   * @brief runBackward Computes, for every vertex, the cost of the best path from it to the last rung
+   *
+   * Combined with run() this gives the cost of the best full path through any vertex, see throughCost().
+   *
+   * @return The cost of the shortest path, identical to the value returned by run()
+   */
+  FloatType runBackward();
+
+  /**
+   * @brief throughCost The cost of the best full path forced through the given vertex. Requires run() and
+   * runBackward() to have been called.
+   * @return std::numeric_limits<FloatType>::max() if no full path passes through the vertex
+   */
+  FloatType throughCost(size_type rung, size_type index) const noexcept;
+
+  /**
+   * @brief shortestPathThrough Reconstructs the best full path forced through the given vertex. Requires run() and
+   * runBackward() to have been called, and throughCost(rung, index) to be finite.
+   */
+  std::vector<predecessor_t> shortestPathThrough(size_type rung, size_type index) const;
+
+  /**
+   * @brief nearOptimalVertices Lists the vertices of a rung whose through-cost does not exceed (1 + epsilon) times the
+   * optimal cost. Every other vertex of the rung can be pruned without losing any such path. Requires run() and
+   * runBackward() to have been called.
+   */
+  std::vector<size_type> nearOptimalVertices(size_type rung, FloatType epsilon) const;
+
+  /**
+   * @brief runCyclic Searches for the cheapest closed path: one that starts at some vertex 's' of the first rung, goes
+   * through every rung and returns to 's' over one of the given closing edges
+   *
+   * Work is shared across the start vertices: a single backward pass gives a lower bound on the cost of any cycle
+   * through each start vertex, start vertices are tried in increasing order of that bound, and each single-source sweep
+   * prunes vertices that cannot beat the best cycle found so far. The search stops as soon as the next bound exceeds
+   * the best cycle, so typically only a few start vertices are ever swept.
+   *
+   * After this call, use shortestCycle() to retrieve the path. shortestPath() and throughCost() are not meaningful.
+   *
+   * @param closing_edges One edge list per vertex of the last rung, with indices into the first rung
+   * @return The cost of the cheapest cycle, including its closing edge, or std::numeric_limits<FloatType>::max()
+   */
+  FloatType runCyclic(const std::vector<typename LadderGraph<FloatType>::EdgeList>& closing_edges);
+
+  /**
+   * @brief shortestCycle The vertex index per rung of the path found by runCyclic(). Its first and last vertices are
+   * joined by a closing edge.
+   */
+  const std::vector<predecessor_t>& shortestCycle() const noexcept { return cycle_; }
+
+  /**
+   * @brief findDisconnections Locates where the ladder breaks apart using only edge connectivity (no costs)
+   *
+   * A forward reachability sweep is run until it dies out at some rung 'last', then a backward sweep from 'last'
+   * finds the nearest rung 'first' from which 'last' can no longer be reached. The window [first, last] is infeasible
+   * while every shorter window inside it is connected. The forward sweep then restarts from 'last' so that every break
+   * along the ladder is reported in a single pass. A rung with no vertices is reported as the window [rung, rung].
+   *
+   * @param graph The graph to analyze
+   * @return The inclusive rung windows [first, last] that disconnect the ladder, in order. Empty if a path exists.
+   */
+  static std::vector<std::pair<size_type, size_type>> findDisconnections(const LadderGraph<FloatType>& graph);
+
 private:
   const LadderGraph<FloatType>& graph_;
+  const bool has_skip_edges_;
 
   struct SolutionRung
   {
     std::vector<FloatType> distance;
     std::vector<predecessor_t> predecessor;
+    std::vector<FloatType> cost_to_go;            // only allocated by runBackward()
+    std::vector<predecessor_t> successor;         // only allocated by runBackward()
+    std::vector<predecessor_t> predecessor_rung;  // only allocated if the graph has skip edges
+    std::vector<predecessor_t> successor_rung;    // only allocated by runBackward() if the graph has skip edges
   };
 
   inline FloatType& distance(size_type rung, size_type index) noexcept { return solution_[rung].distance[index]; }
 
+  inline const FloatType& distance(size_type rung, size_type index) const noexcept
+  {
+    return solution_[rung].distance[index];
+  }
+
+  inline FloatType& costToGo(size_type rung, size_type index) noexcept { return solution_[rung].cost_to_go[index]; }
+
+  inline const FloatType& costToGo(size_type rung, size_type index) const noexcept
+  {
+    return solution_[rung].cost_to_go[index];
+  }
+
+  inline predecessor_t& successor(size_type rung, size_type index) noexcept
+  {
+    return solution_[rung].successor[index];
+  }
+
+  inline const predecessor_t& successor(size_type rung, size_type index) const noexcept
+  {
+    return solution_[rung].successor[index];
+  }
+
   inline predecessor_t& predecessor(size_type rung, size_type index) noexcept
   {
     return solution_[rung].predecessor[index];
@@ -57,7 +190,19 @@ private:
     return solution_[rung].predecessor[index];
   }
 
+  /** @brief Relaxes every out edge, including skip edges, of the given vertex reached at cost 'u_cost' */
+  void relax(size_type rung, size_type index, FloatType u_cost);
+
+  /** @brief Fills 'path' up to 'rung' by following the predecessors of the given vertex */
+  void tracePath(size_type rung, size_type index, std::vector<predecessor_t>& path) const;
+
+  /** @brief The lowest total cost (including the terminal cost) over the last rung and the index of its vertex */
+  std::pair<FloatType, size_type> bestLastVertex() const;
+
   std::vector<SolutionRung> solution_;
+  std::vector<FloatType> initial_costs_;
+  std::vector<FloatType> terminal_costs_;
+  std::vector<predecessor_t> cycle_;
 };
 
 using DAGSearchF = DAGSearch<float>;
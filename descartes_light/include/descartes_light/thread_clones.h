@@ -0,0 +1,107 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2016, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef DESCARTES_LIGHT_THREAD_CLONES_H
+#define DESCARTES_LIGHT_THREAD_CLONES_H
+
+#include <descartes_light/visibility_control.h>
+#include <map>
+#include <memory>
+#include <typeindex>
+#include <typeinfo>
+#include <utility>
+
+namespace descartes_light
+{
+/**
+ * @brief The clones of the collision interfaces, kinematics and edge evaluators used by one worker thread
+ *
+ * A sampler or evaluator calls local() with the instance it shares with the other threads. Within a ThreadCloneScope,
+ * the first call clones the instance with its clone() method and later calls return the same clone, so every thread
+ * works on its own copy of a stateful collision checker without locking. A clone() that returns nullptr declares the
+ * instance safe to share, and the instance itself is used. Outside of a scope local() returns the instance itself.
+ *
+ * The clones are kept until clear() or, once the instance they were made from is destroyed, dropExpired(). A solver
+ * reusing its ThreadClones across builds therefore clones each instance once per thread.
+ */
+class DESCARTES_PUBLIC ThreadClones
+{
+public:
+  ThreadClones() = default;
+  ThreadClones(const ThreadClones&) = delete;
+  ThreadClones& operator=(const ThreadClones&) = delete;
+
+  /** @brief The clone of 'shared' used by the calling thread, or 'shared' itself, see the class description */
+  template <typename T>
+  static T* local(const std::shared_ptr<T>& shared);
+
+  /** @brief Drops every clone */
+  void clear() noexcept;
+
+  /** @brief Drops the clones of instances that have been destroyed */
+  void dropExpired() noexcept;
+
+  /** @brief The clones of the calling thread set by ThreadCloneScope, or nullptr */
+  static ThreadClones* current() noexcept;
+
+private:
+  struct Clone
+  {
+    std::weak_ptr<const void> original;  /** @brief Expires with the instance, whose address may then be reused */
+    std::shared_ptr<void> instance;      /** @brief The clone, or nullptr if the original is shared */
+  };
+
+  std::map<std::pair<const void*, std::type_index>, Clone> clones_;
+};
+
+/**
+ * @brief Makes a ThreadClones the clones of the calling thread for the lifetime of the scope, see ThreadClones::local()
+ */
+class DESCARTES_PUBLIC ThreadCloneScope
+{
+public:
+  /** @param clones The clones, or nullptr to share every instance within the scope */
+  explicit ThreadCloneScope(ThreadClones* clones) noexcept;
+  ~ThreadCloneScope();
+
+  ThreadCloneScope(const ThreadCloneScope&) = delete;
+  ThreadCloneScope& operator=(const ThreadCloneScope&) = delete;
+
+private:
+  ThreadClones* previous_;
+};
+
+template <typename T>
+T* ThreadClones::local(const std::shared_ptr<T>& shared)
+{
+  ThreadClones* clones = current();
+  if (clones == nullptr || shared == nullptr)
+    return shared.get();
+
+  Clone& clone = clones->clones_[std::make_pair(static_cast<const void*>(shared.get()), std::type_index(typeid(T)))];
+  if (clone.original.expired())
+  {
+    clone.original = shared;
+    clone.instance = shared->clone();
+  }
+
+  return clone.instance ? static_cast<T*>(clone.instance.get()) : shared.get();
+}
+
+}  // namespace descartes_light
+
+#endif  // DESCARTES_LIGHT_THREAD_CLONES_H
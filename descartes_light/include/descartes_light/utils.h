@@ -5,6 +5,7 @@
 #include <memory>
 #include <functional>
 #include <vector>
+#include <algorithm>
 #include <cmath>
 #include <Eigen/Geometry>
 
@@ -77,6 +78,130 @@ inline std::vector<FloatType> getRedundantSolutions(const FloatType* sol,
   return redundant_sols;
 }
 
+/**
+ * @brief Compile-time counterparts of IsValidFn and GetRedundantSolutionsFn
+ *
+ * A validity policy is a functor 'bool operator()(const FloatType* sol) const'. A redundant solutions policy is a
+ * functor 'void operator()(const FloatType* sol, Visitor&& visit) const' that calls 'visit(const FloatType*)' once
+ * per redundant solution; the pointed-to solution is only valid for the duration of the call. Kinematics templated on
+ * these policies inline them and need no temporary storage.
+ */
+struct AllSolutionsValid
+{
+  template <typename FloatType>
+  inline bool operator()(const FloatType*) const
+  {
+    return true;
+  }
+};
+
+struct NoRedundantSolutions
+{
+  template <typename FloatType, typename Visitor>
+  inline void operator()(const FloatType*, Visitor&&) const
+  {
+  }
+};
+
+/** @brief Validity policy equivalent to isWithinLimits() */
+template <typename FloatType, std::size_t DOF>
+class WithinLimits
+{
+public:
+  explicit WithinLimits(const Eigen::Matrix<FloatType, Eigen::Dynamic, 2>& limits)
+  {
+    for (std::size_t i = 0; i < DOF; ++i)
+    {
+      lower_[i] = limits(static_cast<Eigen::Index>(i), 0);
+      upper_[i] = limits(static_cast<Eigen::Index>(i), 1);
+    }
+  }
+
+  inline bool operator()(const FloatType* sol) const
+  {
+    for (std::size_t i = 0; i < DOF; ++i)
+      if ((sol[i] < lower_[i]) || (sol[i] > upper_[i]))
+        return false;
+
+    return true;
+  }
+
+private:
+  FloatType lower_[DOF];
+  FloatType upper_[DOF];
+};
+
+/** @brief Redundant solutions policy producing the same solutions, in the same order, as getRedundantSolutions() */
+template <typename FloatType, std::size_t DOF>
+class RedundantSolutionsWithinLimits
+{
+public:
+  explicit RedundantSolutionsWithinLimits(const Eigen::Matrix<FloatType, Eigen::Dynamic, 2>& limits)
+  {
+    for (std::size_t i = 0; i < DOF; ++i)
+    {
+      lower_[i] = limits(static_cast<Eigen::Index>(i), 0);
+      upper_[i] = limits(static_cast<Eigen::Index>(i), 1);
+    }
+  }
+
+  template <typename Visitor>
+  inline void operator()(const FloatType* sol, Visitor&& visit) const
+  {
+    FloatType redundant_sol[DOF];
+    std::copy(sol, sol + DOF, redundant_sol);
+    for (std::size_t i = 0; i < DOF; ++i)
+    {
+      FloatType val = sol[i];
+      while ((val = static_cast<FloatType>(val - 2.0 * M_PI)) > lower_[i])
+      {
+        redundant_sol[i] = val;
+        visit(static_cast<const FloatType*>(redundant_sol));
+      }
+
+      val = sol[i];
+      while ((val += (static_cast<FloatType>(2.0 * M_PI))) < upper_[i])
+      {
+        redundant_sol[i] = val;
+        visit(static_cast<const FloatType*>(redundant_sol));
+      }
+      redundant_sol[i] = sol[i];
+    }
+  }
+
+private:
+  FloatType lower_[DOF];
+  FloatType upper_[DOF];
+};
+
+/** @brief Validity policy wrapping an IsValidFn, which must not be empty */
+template <typename FloatType>
+struct IsValidFnPolicy
+{
+  explicit IsValidFnPolicy(const IsValidFn<FloatType>& fn) : fn(fn) {}
+
+  inline bool operator()(const FloatType* sol) const { return fn(sol); }
+
+  const IsValidFn<FloatType>& fn;
+};
+
+/** @brief Redundant solutions policy wrapping a GetRedundantSolutionsFn, which must not be empty */
+template <typename FloatType, std::size_t DOF>
+struct GetRedundantSolutionsFnPolicy
+{
+  explicit GetRedundantSolutionsFnPolicy(const GetRedundantSolutionsFn<FloatType>& fn) : fn(fn) {}
+
+  template <typename Visitor>
+  inline void operator()(const FloatType* sol, Visitor&& visit) const
+  {
+    const std::vector<FloatType> redundant_sols = fn(sol);
+    for (std::size_t s = 0; s + DOF <= redundant_sols.size(); s += DOF)
+      visit(redundant_sols.data() + s);
+  }
+
+  const GetRedundantSolutionsFn<FloatType>& fn;
+};
+
 template <typename FloatType>
 inline bool isValid(const FloatType* qs, int dof)
 {
@@ -0,0 +1,82 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2016, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <descartes_light/arena.h>
+#include <algorithm>
+#include <cassert>
+
+namespace descartes_light
+{
+namespace
+{
+thread_local MonotonicArena* current_arena = nullptr;
+}  // namespace
+
+MonotonicArena::MonotonicArena(const std::size_t block_size) : block_size_(block_size), block_(0), offset_(0) {}
+
+void* MonotonicArena::allocate(const std::size_t bytes, const std::size_t alignment)
+{
+  assert(alignment != 0 && (alignment & (alignment - 1)) == 0 && alignment <= alignof(std::max_align_t));
+
+  for (; block_ < blocks_.size(); ++block_, offset_ = 0)
+  {
+    const std::size_t begin = (offset_ + alignment - 1) & ~(alignment - 1);
+    if (begin + bytes <= blocks_[block_].size)
+    {
+      offset_ = begin + bytes;
+      return blocks_[block_].data.get() + begin;
+    }
+  }
+
+  // Blocks come from operator new[] and are aligned for any fundamental type
+  Block block;
+  block.size = std::max(block_size_, bytes);
+  block.data.reset(new char[block.size]);
+  blocks_.push_back(std::move(block));
+
+  block_ = blocks_.size() - 1;
+  offset_ = bytes;
+  return blocks_.back().data.get();
+}
+
+void MonotonicArena::reset() noexcept
+{
+  block_ = 0;
+  offset_ = 0;
+}
+
+void MonotonicArena::release() noexcept
+{
+  blocks_.clear();
+  reset();
+}
+
+std::size_t MonotonicArena::capacity() const noexcept
+{
+  std::size_t size = 0;
+  for (const auto& block : blocks_)
+    size += block.size;
+  return size;
+}
+
+MonotonicArena* MonotonicArena::current() noexcept { return current_arena; }
+
+ArenaScope::ArenaScope(MonotonicArena* arena) noexcept : previous_(current_arena) { current_arena = arena; }
+
+ArenaScope::~ArenaScope() { current_arena = previous_; }
+
+}  // namespace descartes_light
@@ -0,0 +1,49 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2016, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <descartes_light/thread_clones.h>
+
+namespace descartes_light
+{
+namespace
+{
+thread_local ThreadClones* current_clones = nullptr;
+}  // namespace
+
+void ThreadClones::clear() noexcept { clones_.clear(); }
+
+void ThreadClones::dropExpired() noexcept
+{
+  for (auto it = clones_.begin(); it != clones_.end();)
+  {
+    if (it->second.original.expired())
+      it = clones_.erase(it);
+    else
+      ++it;
+  }
+}
+
+ThreadClones* ThreadClones::current() noexcept { return current_clones; }
+
+ThreadCloneScope::ThreadCloneScope(ThreadClones* clones) noexcept : previous_(current_clones)
+{
+  current_clones = clones;
+}
+
+ThreadCloneScope::~ThreadCloneScope() { current_clones = previous_; }
+
+}  // namespace descartes_light
@@ -0,0 +1,333 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2016, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <descartes_light/impl/cached_collision.h>
+
+using namespace descartes_light;
+
+// Checks the eviction order, capacity, statistics and sharing of CachedCollision against an uncached reference
+
+namespace
+{
+/** @brief Counts the checks of a collision interface and of its clones */
+struct Counters
+{
+  std::atomic<std::size_t> checks{ 0 };
+  std::atomic<std::size_t> clones{ 0 };
+};
+
+/** @brief A collision interface given by closed form functions of the state */
+class FunctionCollision : public CollisionInterfaceD
+{
+public:
+  explicit FunctionCollision(std::shared_ptr<Counters> counters) : counters_(std::move(counters)) {}
+
+  static bool reference(const double* pos, const std::size_t size)
+  {
+    return std::sin(5 * pos[0] + pos[size - 1]) < 0.5;
+  }
+
+  static double referenceDistance(const double* pos, const std::size_t /*size*/)
+  {
+    return std::cos(pos[0] + 2 * pos[1]);
+  }
+
+  bool validate(const double* pos, const std::size_t size) override
+  {
+    ++counters_->checks;
+    return reference(pos, size);
+  }
+
+  double distance(const double* pos, const std::size_t size) override
+  {
+    ++counters_->checks;
+    return referenceDistance(pos, size);
+  }
+
+  CollisionInterfaceD::Ptr clone() const override
+  {
+    ++counters_->clones;
+    return std::make_shared<FunctionCollision>(counters_);
+  }
+
+private:
+  std::shared_ptr<Counters> counters_;
+};
+
+/** @brief Whether the state (x, 0) is answered by the cache without a check */
+bool cached(CachedCollisionD& cache, const Counters& counters, const double x)
+{
+  const std::vector<double> state = { x, 0.0 };
+  const std::size_t before = counters.checks;
+  cache.validate(state.data(), state.size());
+  return counters.checks == before;
+}
+
+/** @brief 'n' states of 'dof' joints on a grid of 'spacing', picked among 'n_distinct' so that many repeat */
+std::vector<double> randomStates(std::mt19937& rng,
+                                 const std::size_t n,
+                                 const std::size_t dof,
+                                 const int n_distinct,
+                                 const double spacing)
+{
+  std::uniform_int_distribution<int> pick(0, n_distinct - 1);
+  std::vector<double> states;
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    const int s = pick(rng);
+    for (std::size_t j = 0; j < dof; ++j)
+      states.push_back(spacing * s + 0.1 * static_cast<double>(j));
+  }
+  return states;
+}
+}  // namespace
+
+TEST(DescartesLightCachedCollisionUnit, LruEviction)
+{
+  auto counters = std::make_shared<Counters>();
+  CachedCollisionD cache(std::make_shared<FunctionCollision>(counters), 1e-4, 3, CollisionCacheEviction::LRU, 1);
+
+  for (const double x : { 0.0, 1.0, 2.0 })
+    EXPECT_FALSE(cached(cache, *counters, x));
+
+  // The hit on 0 makes 1 the least recently used, which the next state evicts
+  EXPECT_TRUE(cached(cache, *counters, 0.0));
+  EXPECT_FALSE(cached(cache, *counters, 3.0));
+  EXPECT_EQ(cache.getStatistics().evictions, 1u);
+  EXPECT_TRUE(cached(cache, *counters, 0.0));
+  EXPECT_TRUE(cached(cache, *counters, 2.0));
+  EXPECT_TRUE(cached(cache, *counters, 3.0));
+  EXPECT_FALSE(cached(cache, *counters, 1.0));
+}
+
+TEST(DescartesLightCachedCollisionUnit, FifoEviction)
+{
+  auto counters = std::make_shared<Counters>();
+  CachedCollisionD cache(std::make_shared<FunctionCollision>(counters), 1e-4, 3, CollisionCacheEviction::FIFO, 1);
+
+  for (const double x : { 0.0, 1.0, 2.0 })
+    EXPECT_FALSE(cached(cache, *counters, x));
+
+  // The hit on 0 leaves it the oldest, which the next state evicts
+  EXPECT_TRUE(cached(cache, *counters, 0.0));
+  EXPECT_FALSE(cached(cache, *counters, 3.0));
+  EXPECT_EQ(cache.getStatistics().evictions, 1u);
+  EXPECT_TRUE(cached(cache, *counters, 1.0));
+  EXPECT_TRUE(cached(cache, *counters, 2.0));
+  EXPECT_TRUE(cached(cache, *counters, 3.0));
+  EXPECT_FALSE(cached(cache, *counters, 0.0));
+}
+
+TEST(DescartesLightCachedCollisionUnit, CapacityBound)
+{
+  for (const std::size_t n_stripes : { 1u, 4u, 16u })
+  {
+    auto counters = std::make_shared<Counters>();
+    CachedCollisionD cache(
+        std::make_shared<FunctionCollision>(counters), 1e-4, 100, CollisionCacheEviction::LRU, n_stripes);
+
+    for (int i = 0; i < 1000; ++i)
+      EXPECT_FALSE(cached(cache, *counters, 0.01 * i));
+
+    // Every state missed, and all but those still cached were evicted
+    const CollisionCacheStatistics stats = cache.getStatistics();
+    EXPECT_EQ(stats.misses, 1000u);
+    EXPECT_EQ(stats.hits, 0u);
+    EXPECT_LE(stats.misses - stats.evictions, 100u);
+    EXPECT_GE(stats.misses - stats.evictions, 90u);
+
+    // With a single stripe the cache holds exactly the most recent states
+    if (n_stripes == 1)
+    {
+      EXPECT_EQ(stats.evictions, 900u);
+      for (int i = 999; i >= 900; --i)
+      {
+        EXPECT_TRUE(cached(cache, *counters, 0.01 * i));
+      }
+      EXPECT_FALSE(cached(cache, *counters, 0.01 * 899));
+    }
+  }
+}
+
+TEST(DescartesLightCachedCollisionUnit, CapacityBelowStripes)
+{
+  // Fewer entries than stripes: the cache still holds exactly 'capacity' states
+  auto counters = std::make_shared<Counters>();
+  CachedCollisionD cache(std::make_shared<FunctionCollision>(counters), 1e-4, 3, CollisionCacheEviction::LRU, 16);
+
+  for (int i = 0; i < 10; ++i)
+    EXPECT_FALSE(cached(cache, *counters, 0.01 * i));
+  EXPECT_EQ(cache.getStatistics().evictions, 7u);
+
+  std::size_t n_cached = 0;
+  for (int i = 9; i >= 0; --i)
+    n_cached += cached(cache, *counters, 0.01 * i) ? 1u : 0u;
+  EXPECT_LE(n_cached, 3u);
+}
+
+TEST(DescartesLightCachedCollisionUnit, Statistics)
+{
+  auto counters = std::make_shared<Counters>();
+  CachedCollisionD cache(std::make_shared<FunctionCollision>(counters), 1e-3);
+  EXPECT_EQ(cache.getStatistics().hitRate(), 0.0);
+
+  // A state within the resolution of one checked before is a hit, answered with the first result
+  const std::vector<double> a = { 0.3, 0.7 };
+  const std::vector<double> b = { 0.3002, 0.6999 };
+  EXPECT_EQ(cache.validate(a.data(), 2), FunctionCollision::reference(a.data(), 2));
+  EXPECT_EQ(cache.validate(b.data(), 2), FunctionCollision::reference(a.data(), 2));
+  EXPECT_EQ(counters->checks, 1u);
+
+  // The distance of a state whose validity is cached is a miss, after which both are hits
+  EXPECT_EQ(cache.distance(b.data(), 2), FunctionCollision::referenceDistance(b.data(), 2));
+  EXPECT_EQ(cache.distance(a.data(), 2), FunctionCollision::referenceDistance(b.data(), 2));
+  EXPECT_EQ(cache.validate(a.data(), 2), FunctionCollision::reference(a.data(), 2));
+  EXPECT_EQ(counters->checks, 2u);
+
+  CollisionCacheStatistics stats = cache.getStatistics();
+  EXPECT_EQ(stats.hits, 3u);
+  EXPECT_EQ(stats.misses, 2u);
+  EXPECT_EQ(stats.evictions, 0u);
+  EXPECT_DOUBLE_EQ(stats.hitRate(), 0.6);
+
+  // Batches forward only their misses, and count every state
+  const std::vector<double> batch = { 0.3, 0.7, 1.0, 1.0, 0.3, 0.7 };
+  std::vector<char> valid(3);
+  EXPECT_EQ(cache.validateBatch(batch.data(), 2, 3, valid.data()),
+            static_cast<std::size_t>(FunctionCollision::reference(a.data(), 2)) * 2 +
+                static_cast<std::size_t>(FunctionCollision::reference(batch.data() + 2, 2)));
+  EXPECT_EQ(counters->checks, 3u);
+  stats = cache.getStatistics();
+  EXPECT_EQ(stats.hits, 5u);
+  EXPECT_EQ(stats.misses, 3u);
+
+  // Clearing empties the cache and resets the counters
+  cache.clear();
+  stats = cache.getStatistics();
+  EXPECT_EQ(stats.hits + stats.misses + stats.evictions, 0u);
+  cache.validate(a.data(), 2);
+  EXPECT_EQ(counters->checks, 4u);
+}
+
+TEST(DescartesLightCachedCollisionUnit, NestedCaches)
+{
+  // A cache wrapping another, with a different resolution so that their keys differ, used to share batch scratch
+  auto counters = std::make_shared<Counters>();
+  auto inner = std::make_shared<CachedCollisionD>(std::make_shared<FunctionCollision>(counters), 1e-5);
+  CachedCollisionD outer(inner, 1e-3);
+
+  const std::size_t dof = 6;
+  const std::size_t n = 20;
+  std::mt19937 rng(3);
+  std::vector<char> valid(n);
+  std::vector<double> distances(n);
+  for (int it = 0; it < 500; ++it)
+  {
+    const std::vector<double> states = randomStates(rng, n, dof, 500, 1e-3);
+    outer.validateBatch(states.data(), dof, n, valid.data());
+    outer.distanceBatch(states.data(), dof, n, distances.data());
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      const double* state = states.data() + i * dof;
+      EXPECT_EQ(valid[i] != 0, FunctionCollision::reference(state, dof));
+      EXPECT_EQ(distances[i], FunctionCollision::referenceDistance(state, dof));
+      EXPECT_EQ(outer.validate(state, dof), FunctionCollision::reference(state, dof));
+    }
+  }
+
+  // The inner cache only sees the misses of the outer one, and checks each state once
+  const CollisionCacheStatistics outer_stats = outer.getStatistics();
+  const CollisionCacheStatistics inner_stats = inner->getStatistics();
+  EXPECT_GT(outer_stats.hits, 0u);
+  EXPECT_EQ(inner_stats.hits + inner_stats.misses, outer_stats.misses);
+  EXPECT_EQ(counters->checks, inner_stats.misses);
+}
+
+TEST(DescartesLightCachedCollisionUnit, SharedAcrossClones)
+{
+  for (const auto eviction : { CollisionCacheEviction::LRU, CollisionCacheEviction::FIFO })
+  {
+    auto counters = std::make_shared<Counters>();
+    auto cache =
+        std::make_shared<CachedCollisionD>(std::make_shared<FunctionCollision>(counters), 1e-4, 2000, eviction);
+
+    // A clone checks with its own copy of the wrapped collision interface, and sees the entries of the original
+    const std::vector<double> state = { 0.5, 0.25 };
+    cache->validate(state.data(), state.size());
+    auto clone = cache->clone();
+    EXPECT_EQ(counters->clones, 1u);
+    EXPECT_EQ(clone->validate(state.data(), state.size()), FunctionCollision::reference(state.data(), 2));
+    EXPECT_EQ(counters->checks, 1u);
+    EXPECT_EQ(cache->getStatistics().hits, 1u);
+
+    // Threads checking through their own clones get the uncached results, and share what they check
+    const std::size_t dof = 6;
+    const std::size_t n = 50;
+    const std::size_t n_iterations = 400;
+    std::atomic<std::size_t> mismatches(0);
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < 4; ++t)
+    {
+      threads.emplace_back([&cache, &mismatches, t] {
+        auto collision = cache->clone();
+        std::mt19937 rng(t);
+        std::vector<char> valid(n);
+        std::vector<double> distances(n);
+        for (std::size_t it = 0; it < n_iterations; ++it)
+        {
+          const std::vector<double> states = randomStates(rng, n, dof, 3000, 1e-2);
+          collision->validateBatch(states.data(), dof, n, valid.data());
+          collision->distanceBatch(states.data(), dof, n, distances.data());
+          for (std::size_t i = 0; i < n; ++i)
+          {
+            const double* s = states.data() + i * dof;
+            if ((valid[i] != 0) != FunctionCollision::reference(s, dof) ||
+                distances[i] != FunctionCollision::referenceDistance(s, dof) ||
+                collision->validate(s, dof) != (valid[i] != 0))
+              ++mismatches;
+          }
+        }
+      });
+    }
+    for (auto& thread : threads)
+      thread.join();
+
+    EXPECT_EQ(mismatches, 0u);
+    EXPECT_EQ(counters->clones, 5u);
+
+    // The statistics of the original sum those of every clone; each miss is a single check
+    const CollisionCacheStatistics stats = cache->getStatistics();
+    EXPECT_EQ(stats.hits + stats.misses, 2 + 4 * n_iterations * n * 3);
+    EXPECT_EQ(stats.misses, counters->checks);
+    EXPECT_GT(stats.hitRate(), 0.3);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,407 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2016, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <set>
+#include <vector>
+
+#include <descartes_light/descartes_light.h>
+#include <descartes_light/ladder_graph_dag_search.h>
+
+using namespace descartes_light;
+
+// Runs the lazy modes of the solver against eager building and searching on small trajectories of random vertices
+
+namespace
+{
+const std::size_t DOF = 2;
+
+/** @brief A waypoint with fixed vertices, some of which are in collision */
+class FixedSampler : public PositionSamplerD
+{
+public:
+  FixedSampler(std::vector<double> vertices, std::set<std::size_t> invalid)
+    : vertices_(std::move(vertices)), invalid_(std::move(invalid)), n_checks_(0)
+  {
+  }
+
+  bool sample(std::vector<double>& solution_set) override
+  {
+    for (std::size_t i = 0; i < size(); ++i)
+      if (invalid_.count(i) == 0)
+        solution_set.insert(solution_set.end(), vertex(i), vertex(i) + DOF);
+    return size() > invalid_.size();
+  }
+
+  bool sampleUnchecked(std::vector<double>& solution_set) override
+  {
+    solution_set.insert(solution_set.end(), vertices_.begin(), vertices_.end());
+    return !vertices_.empty();
+  }
+
+  bool isValid(const double* v) override
+  {
+    ++n_checks_;
+    return invalid_.count(indexOf(v)) == 0;
+  }
+
+  std::size_t size() const { return vertices_.size() / DOF; }
+
+  const double* vertex(const std::size_t i) const { return vertices_.data() + i * DOF; }
+
+  /** @brief The index of a vertex given by its joint values */
+  std::size_t indexOf(const double* v) const
+  {
+    for (std::size_t i = 0; i < size(); ++i)
+      if (std::equal(v, v + DOF, vertex(i)))
+        return i;
+    return size();
+  }
+
+  void setInvalid(std::set<std::size_t> invalid) { invalid_ = std::move(invalid); }
+
+  std::size_t checks() const { return n_checks_; }
+
+private:
+  std::vector<double> vertices_;
+  std::set<std::size_t> invalid_;
+  std::size_t n_checks_;
+};
+
+/** @brief Connects every pair of vertices at the cost of the sum of their joint distances */
+class DistanceEdges : public EdgeEvaluatorD
+{
+public:
+  bool evaluate(const Rung_<double>& from,
+                const Rung_<double>& to,
+                std::vector<LadderGraphD::EdgeList>& edges) override
+  {
+    const std::size_t n_from = from.data.size() / DOF;
+    const std::size_t n_to = to.data.size() / DOF;
+    edges.resize(n_from);
+    for (std::size_t i = 0; i < n_from; ++i)
+    {
+      edges[i].clear();
+      for (std::size_t j = 0; j < n_to; ++j)
+        edges[i].emplace_back(cost(from.data.data() + i * DOF, to.data.data() + j * DOF), static_cast<unsigned>(j));
+    }
+    return n_from != 0 && n_to != 0;
+  }
+
+  static double cost(const double* a, const double* b)
+  {
+    double c = 0;
+    for (std::size_t j = 0; j < DOF; ++j)
+      c += std::abs(a[j] - b[j]);
+    return c;
+  }
+};
+
+/** @brief Records every vertex whose out edges are evaluated */
+class RecordingEdges : public DistanceEdges
+{
+public:
+  bool evaluate(const Rung_<double>& from,
+                const Rung_<double>& to,
+                std::vector<LadderGraphD::EdgeList>& edges) override
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (auto it = from.data.begin(); it != from.data.end(); it += DOF)
+        evaluated_.emplace_back(it, it + DOF);
+    }
+    return DistanceEdges::evaluate(from, to, edges);
+  }
+
+  const std::vector<std::vector<double>>& evaluated() const { return evaluated_; }
+
+  void clear() { evaluated_.clear(); }
+
+private:
+  std::mutex mutex_;
+  std::vector<std::vector<double>> evaluated_;
+};
+
+/** @brief The samplers of a trajectory of random vertices */
+std::vector<std::shared_ptr<FixedSampler>> makeTrajectory(const std::size_t n_rungs,
+                                                          const std::size_t n_vertices,
+                                                          const unsigned seed)
+{
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> value(-1.0, 1.0);
+
+  std::vector<std::shared_ptr<FixedSampler>> samplers;
+  for (std::size_t r = 0; r < n_rungs; ++r)
+  {
+    std::vector<double> vertices(n_vertices * DOF);
+    for (auto& v : vertices)
+      v = value(rng);
+    samplers.push_back(std::make_shared<FixedSampler>(std::move(vertices), std::set<std::size_t>()));
+  }
+  return samplers;
+}
+
+std::vector<PositionSamplerD::Ptr> asTrajectory(const std::vector<std::shared_ptr<FixedSampler>>& samplers)
+{
+  return std::vector<PositionSamplerD::Ptr>(samplers.begin(), samplers.end());
+}
+
+/** @brief The cost of a path, one vertex per rung */
+double pathCost(const std::vector<double>& path)
+{
+  double c = 0;
+  for (std::size_t i = DOF; i < path.size(); i += DOF)
+    c += DistanceEdges::cost(path.data() + i - DOF, path.data() + i);
+  return c;
+}
+
+std::size_t totalChecks(const std::vector<std::shared_ptr<FixedSampler>>& samplers)
+{
+  std::size_t n = 0;
+  for (const auto& s : samplers)
+    n += s->checks();
+  return n;
+}
+
+/** @brief Builds and searches the trajectory, eagerly or with lazy collision checking */
+bool solve(const std::vector<std::shared_ptr<FixedSampler>>& samplers,
+           const bool lazy,
+           std::vector<double>& solution,
+           const std::vector<double>& start_state = std::vector<double>())
+{
+  SolverD solver(DOF);
+  solver.setLazyCollisionChecking(lazy);
+  const std::vector<descartes_core::TimingConstraintD> times(samplers.size());
+  solver.build(asTrajectory(samplers), times, std::make_shared<DistanceEdges>());
+
+  std::vector<double> initial_costs;
+  if (!start_state.empty())
+    initial_costs = solver.getStartCosts(start_state);
+  return solver.search(solution, initial_costs, std::vector<double>());
+}
+}  // namespace
+
+TEST(DescartesLightSolverUnit, LazyCollisionCheckingMatchesEager)
+{
+  auto samplers = makeTrajectory(8, 6, 42);
+
+  // Put the vertices of the best path in collision on the first, a middle and the last rung, so that the lazy search
+  // has to find and remove them and search again
+  std::vector<double> best;
+  ASSERT_TRUE(solve(samplers, false, best));
+  for (std::size_t r : { std::size_t(0), std::size_t(3), samplers.size() - 1 })
+    samplers[r]->setInvalid({ samplers[r]->indexOf(best.data() + r * DOF) });
+
+  for (const bool seeded : { false, true })
+  {
+    const std::vector<double> start = seeded ? std::vector<double>{ 0.5, -0.5 } : std::vector<double>();
+
+    std::vector<double> eager;
+    ASSERT_TRUE(solve(samplers, false, eager, start));
+
+    const std::size_t checks_before = totalChecks(samplers);
+    std::vector<double> lazy;
+    ASSERT_TRUE(solve(samplers, true, lazy, start));
+
+    EXPECT_EQ(eager, lazy);
+    EXPECT_DOUBLE_EQ(pathCost(eager), pathCost(lazy));
+    EXPECT_GE(totalChecks(samplers) - checks_before, samplers.size() + 1);
+    EXPECT_NE(eager, best);
+  }
+}
+
+TEST(DescartesLightSolverUnit, SavedCollisionChecks)
+{
+  auto samplers = makeTrajectory(10, 8, 7);
+  samplers[4]->setInvalid({ 0, 1, 2, 3, 4, 5 });
+  const std::vector<descartes_core::TimingConstraintD> times(samplers.size());
+
+  SolverD eager(DOF);
+  ASSERT_TRUE(eager.build(asTrajectory(samplers), times, std::make_shared<DistanceEdges>()));
+  std::vector<double> solution;
+  ASSERT_TRUE(eager.search(solution));
+  EXPECT_EQ(eager.getSavedCollisionChecks(), 0u);
+  EXPECT_EQ(totalChecks(samplers), 0u);
+
+  SolverD lazy(DOF);
+  lazy.setLazyCollisionChecking(true);
+  ASSERT_TRUE(lazy.build(asTrajectory(samplers), times, std::make_shared<DistanceEdges>()));
+  EXPECT_EQ(lazy.getSavedCollisionChecks(), 10u * 8u);
+
+  solution.clear();
+  ASSERT_TRUE(lazy.search(solution));
+  const std::size_t checks = totalChecks(samplers);
+  EXPECT_GT(checks, 0u);
+  EXPECT_EQ(lazy.getSavedCollisionChecks(), 10u * 8u - checks);
+
+  // Vertices are checked at most once, so searching again checks nothing new
+  std::vector<double> again;
+  ASSERT_TRUE(lazy.search(again));
+  EXPECT_EQ(again, solution);
+  EXPECT_EQ(totalChecks(samplers), checks);
+}
+
+TEST(DescartesLightSolverUnit, LazyCollisionCheckingRungInCollision)
+{
+  auto samplers = makeTrajectory(6, 5, 3);
+  samplers[2]->setInvalid({ 0, 1, 2, 3, 4 });
+  const std::vector<descartes_core::TimingConstraintD> times(samplers.size());
+
+  SolverD eager(DOF);
+  EXPECT_FALSE(eager.build(asTrajectory(samplers), times, std::make_shared<DistanceEdges>()));
+  EXPECT_EQ(eager.getFailedVertices(), std::vector<std::size_t>{ 2 });
+  std::vector<double> solution;
+  EXPECT_FALSE(eager.search(solution));
+
+  // The lazy build samples every vertex, only the search finds that the rung is in collision
+  SolverD lazy(DOF);
+  lazy.setLazyCollisionChecking(true);
+  EXPECT_TRUE(lazy.build(asTrajectory(samplers), times, std::make_shared<DistanceEdges>()));
+  EXPECT_FALSE(lazy.search(solution));
+  EXPECT_TRUE(solution.empty());
+  EXPECT_EQ(samplers[2]->checks(), 5u);
+  EXPECT_FALSE(lazy.searchCyclic(solution));
+  EXPECT_TRUE(solution.empty());
+}
+
+TEST(DescartesLightSolverUnit, RunLazyMatchesRun)
+{
+  std::mt19937 rng(11);
+  std::uniform_real_distribution<double> cost(0.0, 1.0);
+  const double max_cost = std::numeric_limits<double>::max();
+
+  for (int trial = 0; trial < 50; ++trial)
+  {
+    // Sparse random edges, so that some vertices are dead ends
+    LadderGraphD graph(DOF);
+    graph.resize(7);
+    for (std::size_t r = 0; r < graph.size(); ++r)
+      graph.getRung(r).data.assign(DOF * (3 + static_cast<std::size_t>(trial) % 5), 0.0);
+    for (std::size_t r = 0; r + 1 < graph.size(); ++r)
+    {
+      auto& edges = graph.getEdges(r);
+      edges.resize(graph.rungSize(r));
+      for (auto& out : edges)
+        for (unsigned j = 0; j < graph.rungSize(r + 1); ++j)
+          if (cost(rng) < 0.6)
+            out.emplace_back(cost(rng), j);
+    }
+
+    for (int costs = 0; costs < 3; ++costs)
+    {
+      // None, then initial costs only, then both, each excluding a vertex
+      std::vector<double> initial_costs;
+      std::vector<double> terminal_costs;
+      if (costs > 0)
+      {
+        for (std::size_t i = 0; i < graph.rungSize(0); ++i)
+          initial_costs.push_back(i == 1 ? max_cost : 5.0 * cost(rng));
+      }
+      if (costs > 1)
+      {
+        for (std::size_t i = 0; i < graph.rungSize(graph.size() - 1); ++i)
+          terminal_costs.push_back(i == 0 ? max_cost : 5.0 * cost(rng));
+      }
+
+      DAGSearch<double> eager(graph);
+      const double eager_cost = eager.run(initial_costs, terminal_costs);
+
+      std::size_t n_expanded = 0;
+      DAGSearch<double> lazy(graph);
+      const double lazy_cost = lazy.runLazy(
+          [&graph, &n_expanded](std::size_t rung, std::size_t index) -> const LadderGraphD::EdgeList& {
+            ++n_expanded;
+            return graph.getEdges(rung)[index];
+          },
+          initial_costs,
+          terminal_costs);
+
+      EXPECT_EQ(eager_cost, lazy_cost);
+      EXPECT_LT(n_expanded, graph.numVertices() - graph.rungSize(graph.size() - 1) + 1);
+      if (eager_cost != max_cost)
+      {
+        EXPECT_EQ(eager.shortestPath(), lazy.shortestPath());
+      }
+    }
+  }
+}
+
+TEST(DescartesLightSolverUnit, LazyEdgesMatchEager)
+{
+  // Rungs of 7 vertices leave a partial block for every block size tried
+  auto samplers = makeTrajectory(9, 7, 5);
+  const std::vector<descartes_core::TimingConstraintD> times(samplers.size());
+  const std::size_t n_from_vertices = (samplers.size() - 1) * 7;
+  const std::vector<std::vector<double>> start_states = { {}, { 0.9, 0.9 }, { -0.3, 0.2 }, { 0.0, -1.0 } };
+
+  SolverD eager(DOF);
+  ASSERT_TRUE(eager.build(asTrajectory(samplers), times, std::make_shared<DistanceEdges>()));
+
+  for (const std::size_t block_size : { std::size_t(1), std::size_t(3), std::size_t(4), std::size_t(64) })
+  {
+    auto edge_eval = std::make_shared<RecordingEdges>();
+    SolverD lazy(DOF);
+    lazy.setLazyEdges(true, block_size);
+    ASSERT_TRUE(lazy.build(asTrajectory(samplers), times, edge_eval));
+    EXPECT_TRUE(edge_eval->evaluated().empty());
+
+    // Seeded searches expand the vertices near the start state only. getStartCosts() uses the edge evaluator too.
+    const auto initial_costs = lazy.getStartCosts(start_states[1]);
+    edge_eval->clear();
+    std::vector<double> expected;
+    std::vector<double> solution;
+    ASSERT_TRUE(eager.search(expected, eager.getStartCosts(start_states[1]), std::vector<double>()));
+    ASSERT_TRUE(lazy.search(solution, initial_costs, std::vector<double>()));
+    EXPECT_EQ(expected, solution);
+    if (block_size == 1)
+    {
+      EXPECT_LT(edge_eval->evaluated().size(), n_from_vertices);
+    }
+
+    // Evaluating the rest fills in every out edge exactly once
+    EXPECT_TRUE(lazy.findDisconnections().empty());
+    EXPECT_EQ(edge_eval->evaluated().size(), n_from_vertices);
+    std::vector<std::vector<double>> evaluated = edge_eval->evaluated();
+    std::sort(evaluated.begin(), evaluated.end());
+    EXPECT_EQ(std::unique(evaluated.begin(), evaluated.end()), evaluated.end());
+
+    for (const auto& start : start_states)
+    {
+      expected.clear();
+      solution.clear();
+      const auto eager_costs = start.empty() ? std::vector<double>() : eager.getStartCosts(start);
+      const auto lazy_costs = start.empty() ? std::vector<double>() : lazy.getStartCosts(start);
+      ASSERT_TRUE(eager.search(expected, eager_costs, std::vector<double>()));
+      ASSERT_TRUE(lazy.search(solution, lazy_costs, std::vector<double>()));
+      EXPECT_EQ(expected, solution);
+      EXPECT_DOUBLE_EQ(pathCost(expected), pathCost(solution));
+    }
+  }
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,271 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2016, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <descartes_light/impl/sphere_collision.h>
+
+using namespace descartes_light;
+
+// Compares the batched kernels of SphereCollision with a brute force computation over every pair of spheres
+
+namespace
+{
+const std::size_t DOF = 6;
+
+template <typename FloatType>
+using Transform = typename SphereCollision<FloatType>::Transform;
+
+template <typename FloatType>
+using Vector3 = typename SphereCollision<FloatType>::Vector3;
+
+/** @brief A three link arm whose joints turn about z and then y, with links 0.4 long. States with q0 >= 3 have no
+ * poses. */
+template <typename FloatType>
+bool armPoses(const FloatType* q, const std::size_t /*size*/, typename SphereCollision<FloatType>::TransformVector& p)
+{
+  p.resize(3);
+  Transform<FloatType> t = Transform<FloatType>::Identity();
+  for (std::size_t k = 0; k < 3; ++k)
+  {
+    t = t * Eigen::AngleAxis<FloatType>(q[k], Vector3<FloatType>::UnitZ()) *
+        Eigen::AngleAxis<FloatType>(q[3 + k], Vector3<FloatType>::UnitY());
+    p[k] = t;
+    t = t * Eigen::Translation<FloatType, 3>(FloatType(0.4), 0, 0);
+  }
+  return q[0] < FloatType(3.0);
+}
+
+/** @brief A single link whose pose is the translation given by the first three joints */
+template <typename FloatType>
+bool pointPoses(const FloatType* q, const std::size_t /*size*/, typename SphereCollision<FloatType>::TransformVector& p)
+{
+  p.assign(1, Transform<FloatType>::Identity());
+  p[0].translation() = Vector3<FloatType>(q[0], q[1], q[2]);
+  return true;
+}
+
+template <typename FloatType>
+struct Scene
+{
+  std::vector<CollisionSphere<FloatType>> robot;
+  std::vector<std::pair<Vector3<FloatType>, FloatType>> spheres;
+  std::vector<std::pair<Transform<FloatType>, Vector3<FloatType>>> boxes;
+};
+
+template <typename FloatType>
+Scene<FloatType> makeScene(std::mt19937& rng)
+{
+  std::uniform_real_distribution<double> u(-1.0, 1.0);
+  const auto value = [&rng, &u](double scale, double offset) { return FloatType(offset + scale * u(rng)); };
+
+  Scene<FloatType> scene;
+  for (std::size_t k = 0; k < 3; ++k)
+    for (int j = 0; j < 4; ++j)
+      scene.robot.push_back(
+          CollisionSphere<FloatType>{ k, Vector3<FloatType>(FloatType(0.1 * (j + 1)), 0, 0), FloatType(0.06) });
+
+  for (int i = 0; i < 40; ++i)
+  {
+    const Vector3<FloatType> center(value(2, 0), value(2, 0), value(2, 0));
+    scene.spheres.emplace_back(center, std::abs(value(0.05, 0)) + FloatType(0.05));
+  }
+
+  for (int i = 0; i < 20; ++i)
+  {
+    Transform<FloatType> pose = Transform<FloatType>::Identity();
+    pose.translate(Vector3<FloatType>(value(2, 0), value(2, 0), value(2, 0)));
+    const Vector3<FloatType> axis(value(1, 0), value(1, 0), value(1, 0));
+    pose.rotate(Eigen::AngleAxis<FloatType>(value(3, 0), axis.normalized()));
+    const Vector3<FloatType> half_extents(
+        std::abs(value(0.1, 0)) + FloatType(0.02), std::abs(value(0.1, 0)) + FloatType(0.02), value(0.1, 0.02));
+    scene.boxes.emplace_back(pose, half_extents);
+  }
+  return scene;
+}
+
+/** @brief The smallest signed distance between a robot sphere and an obstacle, by brute force in double */
+template <typename FloatType>
+double referenceDistance(const Scene<FloatType>& scene, const FloatType* q)
+{
+  typename SphereCollision<FloatType>::TransformVector poses;
+  if (!armPoses(q, DOF, poses))
+    return std::numeric_limits<double>::lowest();
+
+  double d = std::numeric_limits<double>::max();
+  for (const auto& sphere : scene.robot)
+  {
+    const Eigen::Vector3d center = (poses[sphere.link] * sphere.center).template cast<double>();
+    for (const auto& obstacle : scene.spheres)
+      d = std::min(d, (center - obstacle.first.template cast<double>()).norm() - double(sphere.radius) -
+                          double(obstacle.second));
+
+    for (const auto& box : scene.boxes)
+    {
+      const Eigen::Vector3d local = box.first.template cast<double>().inverse() * center;
+      const Eigen::Vector3d a = local.cwiseAbs() - box.second.template cast<double>().cwiseAbs();
+      const double outside = a.cwiseMax(Eigen::Vector3d::Zero()).norm();
+      const double inside = std::min(a.maxCoeff(), 0.0);
+      d = std::min(d, outside + inside - double(sphere.radius));
+    }
+  }
+  return d;
+}
+
+template <typename FloatType>
+void compareWithReference(const double distance_tolerance)
+{
+  std::mt19937 rng(7);
+  const Scene<FloatType> scene = makeScene<FloatType>(rng);
+  const FloatType margin = FloatType(0.01);
+
+  SphereCollision<FloatType> collision(armPoses<FloatType>, scene.robot, margin);
+  for (const auto& obstacle : scene.spheres)
+    collision.addSphere(obstacle.first, obstacle.second);
+  for (const auto& box : scene.boxes)
+    collision.addBox(box.first, box.second);
+
+  const std::size_t n = 20000;
+  std::uniform_real_distribution<double> u(-3.2, 3.2);
+  std::vector<FloatType> q(n * DOF);
+  for (auto& v : q)
+    v = FloatType(u(rng));
+
+  std::vector<char> valid(n);
+  std::vector<FloatType> distances(n);
+  const std::size_t n_valid = collision.validateBatch(q.data(), DOF, n, valid.data());
+  collision.distanceBatch(q.data(), DOF, n, distances.data());
+  EXPECT_EQ(n_valid, static_cast<std::size_t>(std::count(valid.begin(), valid.end(), 1)));
+
+  std::size_t n_unposed = 0;
+  std::size_t n_colliding = 0;
+  for (std::size_t s = 0; s < n; ++s)
+  {
+    const FloatType* state = q.data() + s * DOF;
+    const double expected = referenceDistance(scene, state);
+    EXPECT_EQ(collision.validate(state, DOF), valid[s] != 0);
+    EXPECT_EQ(collision.distance(state, DOF), distances[s]);
+
+    if (expected == std::numeric_limits<double>::lowest())
+    {
+      ++n_unposed;
+      EXPECT_FALSE(valid[s]);
+      EXPECT_EQ(distances[s], std::numeric_limits<FloatType>::lowest());
+      continue;
+    }
+
+    n_colliding += expected < double(margin) ? 1u : 0u;
+    EXPECT_NEAR(double(distances[s]), expected, distance_tolerance);
+
+    // Right at the margin the squared and the square rooted comparisons may round apart
+    if (std::abs(expected - double(margin)) > distance_tolerance)
+    {
+      EXPECT_EQ(valid[s] != 0, expected >= double(margin));
+      EXPECT_EQ(valid[s] != 0, distances[s] >= margin);
+    }
+  }
+
+  // Both outcomes are well represented
+  EXPECT_GT(n_unposed, 0u);
+  EXPECT_GT(n_colliding, n / 10);
+  EXPECT_GT(n_valid, n / 10);
+}
+
+template <typename FloatType>
+void checkMarginAndClamping()
+{
+  const auto at = [](double x, double y, double z) {
+    std::vector<FloatType> q(DOF, FloatType(0));
+    q[0] = FloatType(x);
+    q[1] = FloatType(y);
+    q[2] = FloatType(z);
+    return q;
+  };
+
+  // A sphere of radius 0.1 at 0.2 from the center of an obstacle of radius 0.08: a clearance of 0.02
+  const std::vector<CollisionSphere<FloatType>> ball = { { 0, Vector3<FloatType>::Zero(), FloatType(0.1) } };
+  for (const double margin : { -0.5, 0.0, 0.01, 0.03 })
+  {
+    SphereCollision<FloatType> collision(pointPoses<FloatType>, ball, FloatType(margin));
+    collision.addSphere(Vector3<FloatType>::Zero(), FloatType(0.08));
+    const auto q = at(0.2, 0, 0);
+    EXPECT_NEAR(double(collision.distance(q.data(), DOF)), 0.02, 1e-6);
+    EXPECT_EQ(collision.validate(q.data(), DOF), margin < 0.02);
+    EXPECT_EQ(collision.validate(q.data(), DOF),
+              collision.distance(q.data(), DOF) >= std::max(FloatType(margin), FloatType(0)));
+  }
+
+  // Without obstacles every state is valid
+  {
+    SphereCollision<FloatType> collision(pointPoses<FloatType>, ball, FloatType(0.01));
+    const auto q = at(0, 0, 0);
+    EXPECT_TRUE(collision.validate(q.data(), DOF));
+    EXPECT_EQ(collision.distance(q.data(), DOF), std::numeric_limits<FloatType>::max());
+  }
+
+  // Robot spheres of zero or negative radius become points, which collide inside a box and on its surface
+  for (const double radius : { 0.0, -0.1 })
+  {
+    const std::vector<CollisionSphere<FloatType>> point = { { 0, Vector3<FloatType>::Zero(), FloatType(radius) } };
+    SphereCollision<FloatType> collision(pointPoses<FloatType>, point, FloatType(0));
+    collision.addBox(Transform<FloatType>::Identity(), Vector3<FloatType>::Constant(FloatType(0.3)));
+
+    for (const auto& q : { at(0, 0, 0), at(0.1, -0.2, 0.25), at(0.3, 0, 0) })
+    {
+      EXPECT_FALSE(collision.validate(q.data(), DOF));
+      EXPECT_LE(collision.distance(q.data(), DOF), FloatType(0));
+    }
+
+    const auto outside = at(0.35, 0, 0);
+    EXPECT_TRUE(collision.validate(outside.data(), DOF));
+    EXPECT_NEAR(double(collision.distance(outside.data(), DOF)), 0.05, 1e-6);
+  }
+
+  // Obstacles of negative radius count as points
+  {
+    SphereCollision<FloatType> collision(pointPoses<FloatType>, ball, FloatType(0));
+    collision.addSphere(Vector3<FloatType>::Zero(), FloatType(-0.2));
+    for (const double x : { 0.05, 0.15 })
+    {
+      const auto q = at(x, 0, 0);
+      EXPECT_NEAR(double(collision.distance(q.data(), DOF)), x - 0.1, 1e-6);
+      EXPECT_EQ(collision.validate(q.data(), DOF), x > 0.1);
+    }
+  }
+}
+}  // namespace
+
+TEST(DescartesLightSphereCollisionUnit, MatchesReferenceDouble) { compareWithReference<double>(1e-9); }
+
+TEST(DescartesLightSphereCollisionUnit, MatchesReferenceFloat) { compareWithReference<float>(1e-4); }
+
+TEST(DescartesLightSphereCollisionUnit, MarginAndClampingDouble) { checkMarginAndClamping<double>(); }
+
+TEST(DescartesLightSphereCollisionUnit, MarginAndClampingFloat) { checkMarginAndClamping<float>(); }
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -4,6 +4,7 @@
 #include <descartes_light/visibility_control.h>
 #include <descartes_light/interface/kinematics_interface.h>
 #include <descartes_light/utils.h>
+#include <descartes_opw/opw_batch.h>
 #include <opw_kinematics/opw_kinematics.h>
 
 namespace descartes_light
@@ -20,6 +21,16 @@ public:
 
   bool ik(const Eigen::Transform<FloatType, 3, Eigen::Isometry>& p,
           std::vector<FloatType>& solution_set) const override;
+
+  /**
+   * @brief Batched IK, solved OPW_BATCH_SIZE poses at a time with the vectorized solver, see opwInverseBatch(). The
+   * base and tool transforms are inverted once for the whole batch.
+   */
+  bool ik(const Eigen::Transform<FloatType, 3, Eigen::Isometry>* poses,
+          const std::size_t n,
+          std::vector<FloatType>& solution_set,
+          std::vector<std::size_t>& offsets) const override;
+
   bool fk(const FloatType* pose, Eigen::Transform<FloatType, 3, Eigen::Isometry>& solution) const override;
 
   int dof() const override;
@@ -32,11 +43,24 @@ private:
   Eigen::Transform<FloatType, 3, Eigen::Isometry> tool0_to_tip_;
   IsValidFn<FloatType> is_valid_fn_;
   GetRedundantSolutionsFn<FloatType> redundant_sol_fn_;
+  OPWBatchParameters<FloatType> batch_params_;
 
   bool ik(const Eigen::Transform<FloatType, 3, Eigen::Isometry>& p,
           const IsValidFn<FloatType>& is_valid_fn,
           const GetRedundantSolutionsFn<FloatType>& redundant_sol_fn,
           std::vector<FloatType>& solution_set) const;
+
+  /** @brief Solves IK for a pose of the tip given in the robot base frame */
+  bool ikInBase(const Eigen::Transform<FloatType, 3, Eigen::Isometry>& tool_pose,
+                const IsValidFn<FloatType>& is_valid_fn,
+                const GetRedundantSolutionsFn<FloatType>& redundant_sol_fn,
+                std::vector<FloatType>& solution_set) const;
+
+  /** @brief Filters the 8 candidate solutions in 'sols' and appends them, with their redundant solutions, to the set */
+  void appendSolutions(FloatType* sols,
+                       const IsValidFn<FloatType>& is_valid_fn,
+                       const GetRedundantSolutionsFn<FloatType>& redundant_sol_fn,
+                       std::vector<FloatType>& solution_set) const;
 };
 
 using OPWKinematicsF = OPWKinematics<float>;
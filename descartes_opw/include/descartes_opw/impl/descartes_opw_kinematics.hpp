@@ -20,8 +20,10 @@
 
 //#include "descartes_opw/impl/descartes_opw_half.hpp"
 #include "descartes_opw/descartes_opw_kinematics.h"
+#include "descartes_opw/impl/opw_policy_kinematics.hpp"
 #include <opw_kinematics/opw_utilities.h>
 #include <console_bridge/console.h>
+#include <algorithm>
 #include <array>
 
 namespace descartes_light
@@ -37,6 +39,7 @@ OPWKinematics<FloatType>::OPWKinematics(const opw_kinematics::Parameters<FloatTy
   , tool0_to_tip_(tool0_to_tip)
   , is_valid_fn_(is_valid_fn)
   , redundant_sol_fn_(redundant_sol_fn)
+  , batch_params_(toOPWBatchParameters(params))
 {
 }
 
@@ -47,74 +50,67 @@ bool OPWKinematics<FloatType>::ik(const Eigen::Transform<FloatType, 3, Eigen::Is
   return ik(p, is_valid_fn_, redundant_sol_fn_, solution_set);
 }
 
+template <typename FloatType>
+bool OPWKinematics<FloatType>::ik(const Eigen::Transform<FloatType, 3, Eigen::Isometry>* poses,
+                                  const std::size_t n,
+                                  std::vector<FloatType>& solution_set,
+                                  std::vector<std::size_t>& offsets) const
+{
+  return opwBatchIK(batch_params_,
+                    world_to_base_.inverse(),
+                    tool0_to_tip_.inverse(),
+                    poses,
+                    n,
+                    solution_set,
+                    offsets,
+                    [this, &solution_set](FloatType* sols) {
+                      appendSolutions(sols, is_valid_fn_, redundant_sol_fn_, solution_set);
+                    });
+}
+
 template <typename FloatType>
 bool OPWKinematics<FloatType>::ik(const Eigen::Transform<FloatType, 3, Eigen::Isometry>& p,
                                   const IsValidFn<FloatType>& is_valid_fn,
                                   const GetRedundantSolutionsFn<FloatType>& redundant_sol_fn,
                                   std::vector<FloatType>& solution_set) const
 {
-  Eigen::Transform<FloatType, 3, Eigen::Isometry> tool_pose = world_to_base_.inverse() * p * tool0_to_tip_.inverse();
+  return ikInBase(world_to_base_.inverse() * p * tool0_to_tip_.inverse(), is_valid_fn, redundant_sol_fn, solution_set);
+}
 
+template <typename FloatType>
+bool OPWKinematics<FloatType>::ikInBase(const Eigen::Transform<FloatType, 3, Eigen::Isometry>& tool_pose,
+                                        const IsValidFn<FloatType>& is_valid_fn,
+                                        const GetRedundantSolutionsFn<FloatType>& redundant_sol_fn,
+                                        std::vector<FloatType>& solution_set) const
+{
   std::array<FloatType, 6 * 8> sols;
   opw_kinematics::inverse(params_, tool_pose, sols.data());
 
-  // Check the output
-  for (int i = 0; i < 8; i++)
-  {
-    FloatType* sol = sols.data() + 6 * i;
-    if (opw_kinematics::isValid(sol))
-    {
-      opw_kinematics::harmonizeTowardZero(sol);  // Modifies 'sol' in place
-
-      if (is_valid_fn && redundant_sol_fn)
-      {
-        if (is_valid_fn_(sol))
-          solution_set.insert(end(solution_set), sol, sol + 6);  // If good then add to solution set
-
-        std::vector<FloatType> redundant_sols = redundant_sol_fn(sol);
-        if (!redundant_sols.empty())
-        {
-          int num_sol = static_cast<int>(redundant_sols.size() / 6);
-          for (int s = 0; s < num_sol; ++s)
-          {
-            FloatType* redundant_sol = redundant_sols.data() + 6 * s;
-            if (is_valid_fn_(redundant_sol))
-              solution_set.insert(end(solution_set), redundant_sol, redundant_sol + 6);  // If good then add to solution
-                                                                                         // set
-          }
-        }
-      }
-      else if (is_valid_fn && !redundant_sol_fn)
-      {
-        if (is_valid_fn(sol))
-          solution_set.insert(end(solution_set), sol, sol + 6);  // If good then add to solution set
-      }
-      else if (!is_valid_fn && redundant_sol_fn)
-      {
-        solution_set.insert(end(solution_set), sol, sol + 6);  // If good then add to solution set
-
-        std::vector<FloatType> redundant_sols = redundant_sol_fn(sol);
-        if (!redundant_sols.empty())
-        {
-          int num_sol = static_cast<int>(redundant_sols.size() / 6);
-          for (int s = 0; s < num_sol; ++s)
-          {
-            FloatType* redundant_sol = redundant_sols.data() + 6 * s;
-            solution_set.insert(end(solution_set), redundant_sol, redundant_sol + 6);  // If good then add to solution
-                                                                                       // set
-          }
-        }
-      }
-      else
-      {
-        solution_set.insert(end(solution_set), sol, sol + 6);
-      }
-    }
-  }
-
+  appendSolutions(sols.data(), is_valid_fn, redundant_sol_fn, solution_set);
   return !solution_set.empty();
 }
 
+template <typename FloatType>
+void OPWKinematics<FloatType>::appendSolutions(FloatType* sols,
+                                               const IsValidFn<FloatType>& is_valid_fn,
+                                               const GetRedundantSolutionsFn<FloatType>& redundant_sol_fn,
+                                               std::vector<FloatType>& solution_set) const
+{
+  // Pick the policies once per pose rather than testing the functions for every candidate solution
+  if (is_valid_fn && redundant_sol_fn)
+    appendOPWSolutions(sols,
+                       IsValidFnPolicy<FloatType>(is_valid_fn),
+                       GetRedundantSolutionsFnPolicy<FloatType, 6>(redundant_sol_fn),
+                       solution_set);
+  else if (is_valid_fn && !redundant_sol_fn)
+    appendOPWSolutions(sols, IsValidFnPolicy<FloatType>(is_valid_fn), NoRedundantSolutions(), solution_set);
+  else if (!is_valid_fn && redundant_sol_fn)
+    appendOPWSolutions(
+        sols, AllSolutionsValid(), GetRedundantSolutionsFnPolicy<FloatType, 6>(redundant_sol_fn), solution_set);
+  else
+    appendOPWSolutions(sols, AllSolutionsValid(), NoRedundantSolutions(), solution_set);
+}
+
 template <typename FloatType>
 bool OPWKinematics<FloatType>::fk(const FloatType* pose,
                                   Eigen::Transform<FloatType, 3, Eigen::Isometry>& solution) const
@@ -0,0 +1,305 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2016, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef DESCARTES_OPW_IMPL_OPW_BATCH_KERNEL_HPP
+#define DESCARTES_OPW_IMPL_OPW_BATCH_KERNEL_HPP
+
+// The lane loop below is compiled once per instruction set, each time in a namespace named by
+// DESCARTES_OPW_BATCH_ISA. Every helper lives in that namespace and no library functions are called from it, so code
+// built for a wider instruction set can never be picked up by the linker in place of the baseline code.
+#ifndef DESCARTES_OPW_BATCH_ISA
+#error "DESCARTES_OPW_BATCH_ISA must name the instruction set this kernel is compiled for"
+#endif
+
+#include <descartes_opw/opw_batch.h>
+#include <cmath>
+
+#if defined(__GNUC__)
+#define DESCARTES_OPW_BATCH_INLINE inline __attribute__((always_inline))
+#define DESCARTES_OPW_BATCH_SIMD _Pragma("omp simd")
+#else
+#define DESCARTES_OPW_BATCH_INLINE inline
+#define DESCARTES_OPW_BATCH_SIMD
+#endif
+
+namespace descartes_light
+{
+namespace opw_batch
+{
+namespace DESCARTES_OPW_BATCH_ISA
+{
+// The transcendental functions are branch free so that the compiler can vectorize the lane loop. They follow the
+// Cephes range reductions and coefficients, and are accurate to a few ulp in double precision.
+
+#if defined(__GNUC__)
+DESCARTES_OPW_BATCH_INLINE double sqrtLane(const double x) { return __builtin_sqrt(x); }
+DESCARTES_OPW_BATCH_INLINE float sqrtLane(const float x) { return __builtin_sqrtf(x); }
+DESCARTES_OPW_BATCH_INLINE double absLane(const double x) { return __builtin_fabs(x); }
+DESCARTES_OPW_BATCH_INLINE float absLane(const float x) { return __builtin_fabsf(x); }
+DESCARTES_OPW_BATCH_INLINE double copySignLane(const double x, const double s) { return __builtin_copysign(x, s); }
+DESCARTES_OPW_BATCH_INLINE float copySignLane(const float x, const float s) { return __builtin_copysignf(x, s); }
+#else
+DESCARTES_OPW_BATCH_INLINE double sqrtLane(const double x) { return std::sqrt(x); }
+DESCARTES_OPW_BATCH_INLINE float sqrtLane(const float x) { return std::sqrt(x); }
+DESCARTES_OPW_BATCH_INLINE double absLane(const double x) { return std::abs(x); }
+DESCARTES_OPW_BATCH_INLINE float absLane(const float x) { return std::abs(x); }
+DESCARTES_OPW_BATCH_INLINE double copySignLane(const double x, const double s) { return std::copysign(x, s); }
+DESCARTES_OPW_BATCH_INLINE float copySignLane(const float x, const float s) { return std::copysign(x, s); }
+#endif
+
+/** @brief Adding then subtracting this rounds to the nearest integer (1.5 * 2^52 and 1.5 * 2^23) */
+DESCARTES_OPW_BATCH_INLINE double roundMagic(double) { return 6755399441055744.0; }
+DESCARTES_OPW_BATCH_INLINE float roundMagic(float) { return 12582912.0f; }
+
+template <typename FloatType>
+DESCARTES_OPW_BATCH_INLINE FloatType roundLane(const FloatType x)
+{
+  return (x + roundMagic(x)) - roundMagic(x);
+}
+
+template <typename FloatType>
+DESCARTES_OPW_BATCH_INLINE FloatType floorLane(const FloatType x)
+{
+  const FloatType r = roundLane(x);
+  return r > x ? r - FloatType(1) : r;
+}
+
+/** @brief Arc tangent of 0 <= x <= 1 */
+template <typename FloatType>
+DESCARTES_OPW_BATCH_INLINE FloatType atanUnitLane(const FloatType x)
+{
+  // Above tan(pi / 8) the argument is reduced with atan(x) = pi / 4 + atan((x - 1) / (x + 1))
+  const bool reduce = x > FloatType(0.66);
+  const FloatType xr = reduce ? (x - FloatType(1)) / (x + FloatType(1)) : x;
+  const FloatType y0 = reduce ? FloatType(M_PI_4) : FloatType(0);
+  const FloatType more = reduce ? FloatType(3.061616997868382943065E-17) : FloatType(0);
+
+  const FloatType z = xr * xr;
+  const FloatType p = (((FloatType(-8.750608600031904122785E-1) * z + FloatType(-1.615753718733365076637E1)) * z +
+                        FloatType(-7.500855792314704667340E1)) *
+                           z +
+                       FloatType(-1.228866684490136173410E2)) *
+                          z +
+                      FloatType(-6.485021904942025371773E1);
+  const FloatType q = ((((z + FloatType(2.485846490142306297962E1)) * z + FloatType(1.650270098316988542046E2)) * z +
+                        FloatType(4.328810604912902668951E2)) *
+                           z +
+                       FloatType(4.853903996359136964868E2)) *
+                          z +
+                      FloatType(1.945506571482613964425E2);
+
+  return y0 + (xr * z * p / q + xr) + more;
+}
+
+/**
+ * @brief Arc tangent of y / x in [-pi, pi], NaN if either input is NaN
+ *
+ * The ratio of the smaller to the larger magnitude is always in [0, 1], so no select depends on 'y' alone. A
+ * loop-invariant 'y' (such as the OPW offset 'b') therefore never produces a loop-invariant mask, which the
+ * vectorizer cannot handle.
+ */
+template <typename FloatType>
+DESCARTES_OPW_BATCH_INLINE FloatType atan2Lane(const FloatType y, const FloatType x)
+{
+  const FloatType ax = absLane(x);
+  const FloatType ay = absLane(y);
+
+  // A NaN in either input makes 'steep' false and ends up in the ratio
+  const bool steep = ay > ax;
+  const FloatType num = steep ? ax : ay;
+  const FloatType den = steep ? ay : ax;
+
+  // atan2(0, 0) is 0: the denominator is kept away from zero
+  const FloatType t = num / (den < FloatType(1e-30) ? FloatType(1e-30) : den);
+
+  FloatType r = atanUnitLane(t);
+  r = steep ? FloatType(M_PI_2) - r : r;
+  r = x < FloatType(0) ? FloatType(M_PI) - r : r;
+  return copySignLane(r, y);
+}
+
+/** @brief Arc cosine, NaN outside of [-1, 1] */
+template <typename FloatType>
+DESCARTES_OPW_BATCH_INLINE FloatType acosLane(const FloatType x)
+{
+  return atan2Lane(sqrtLane((FloatType(1) - x) * (FloatType(1) + x)), x);
+}
+
+template <typename FloatType>
+DESCARTES_OPW_BATCH_INLINE void sinCosLane(const FloatType x, FloatType& s, FloatType& c)
+{
+  // Reduce to [-pi/4, pi/4] in three steps so that j * (pi / 2) is subtracted exactly
+  const FloatType j = roundLane(x * FloatType(M_2_PI));
+  const FloatType r = ((x - j * FloatType(1.57079625129699707031)) - j * FloatType(7.54978941586159635335E-8)) -
+                      j * FloatType(5.39030285815811905290E-15);
+  const FloatType z = r * r;
+
+  const FloatType sp = r + r * z * (((((FloatType(1.58962301576546568060E-10) * z +
+                                        FloatType(-2.50507477628578072866E-8)) *
+                                           z +
+                                       FloatType(2.75573136213857245213E-6)) *
+                                          z +
+                                      FloatType(-1.98412698295895385996E-4)) *
+                                         z +
+                                     FloatType(8.33333333332211858878E-3)) *
+                                        z +
+                                    FloatType(-1.66666666666666307295E-1));
+  const FloatType cp = FloatType(1) - FloatType(0.5) * z +
+                       z * z * (((((FloatType(-1.13585365213876817300E-11) * z + FloatType(2.08757008419747316778E-9)) *
+                                       z +
+                                   FloatType(-2.75573141792967388112E-7)) *
+                                      z +
+                                  FloatType(2.48015872888517045348E-5)) *
+                                     z +
+                                 FloatType(-1.38888888888730564116E-3)) *
+                                    z +
+                                FloatType(4.16666666666665929218E-2));
+
+  // Quadrant of x, in {0, 1, 2, 3}
+  const FloatType m = j - FloatType(4) * floorLane(j * FloatType(0.25));
+  const bool odd = m == FloatType(1) || m == FloatType(3);
+  const FloatType s_sign = m > FloatType(1) ? FloatType(-1) : FloatType(1);
+  const FloatType c_sign = (m == FloatType(1) || m == FloatType(2)) ? FloatType(-1) : FloatType(1);
+  s = (odd ? cp : sp) * s_sign;
+  c = (odd ? sp : cp) * c_sign;
+}
+
+template <typename FloatType>
+DESCARTES_OPW_BATCH_INLINE void storeJoint(const OPWBatchParameters<FloatType>& p,
+                                           const std::size_t joint,
+                                           const FloatType theta,
+                                           FloatType (&out)[6][OPW_BATCH_SIZE],
+                                           const std::size_t lane)
+{
+  out[joint][lane] = (theta + p.offsets[joint]) * p.sign_corrections[joint];
+}
+
+/** @brief Solves the wrist of one arm configuration, writing solution 'k' and its flipped wrist 'k + 4' */
+template <typename FloatType>
+DESCARTES_OPW_BATCH_INLINE void solveWrist(const OPWBatchParameters<FloatType>& p,
+                                           const OPWPoseBatch<FloatType>& poses,
+                                           const std::size_t lane,
+                                           const FloatType theta1,
+                                           const FloatType theta2,
+                                           const FloatType theta3,
+                                           FloatType (&out)[6][OPW_BATCH_SIZE],
+                                           FloatType (&out_flipped)[6][OPW_BATCH_SIZE])
+{
+  const FloatType r00 = poses.r[0][lane], r01 = poses.r[1][lane], r02 = poses.r[2][lane];
+  const FloatType r10 = poses.r[3][lane], r11 = poses.r[4][lane], r12 = poses.r[5][lane];
+  const FloatType r20 = poses.r[6][lane], r21 = poses.r[7][lane], r22 = poses.r[8][lane];
+
+  FloatType s1, c1, s23, c23;
+  sinCosLane(theta1, s1, c1);
+  sinCosLane(theta2 + theta3, s23, c23);
+
+  const FloatType m = r02 * s23 * c1 + r12 * s23 * s1 + r22 * c23;
+  const FloatType theta4 = atan2Lane(r12 * c1 - r02 * s1, r02 * c23 * c1 + r12 * c23 * s1 - r22 * s23);
+  const FloatType theta5 = atan2Lane(sqrtLane(FloatType(1) - m * m), m);
+  const FloatType theta6 =
+      atan2Lane(r01 * s23 * c1 + r11 * s23 * s1 + r21 * c23, -r00 * s23 * c1 - r10 * s23 * s1 - r20 * c23);
+
+  storeJoint(p, 0, theta1, out, lane);
+  storeJoint(p, 1, theta2, out, lane);
+  storeJoint(p, 2, theta3, out, lane);
+  storeJoint(p, 3, theta4, out, lane);
+  storeJoint(p, 4, theta5, out, lane);
+  storeJoint(p, 5, theta6, out, lane);
+
+  storeJoint(p, 0, theta1, out_flipped, lane);
+  storeJoint(p, 1, theta2, out_flipped, lane);
+  storeJoint(p, 2, theta3, out_flipped, lane);
+  storeJoint(p, 3, theta4 + FloatType(M_PI), out_flipped, lane);
+  storeJoint(p, 4, -theta5, out_flipped, lane);
+  storeJoint(p, 5, theta6 - FloatType(M_PI), out_flipped, lane);
+}
+
+/**
+ * @brief The lane loops of opwInverseBatch(), following the closed form of opw_kinematics::inverse()
+ *
+ * The arm and the wrist are solved in separate loops, passing the arm angles through small per-lane arrays. Keeping
+ * each loop body short helps the compiler if-convert and vectorize it.
+ */
+template <typename FloatType>
+void inverse(const OPWBatchParameters<FloatType>& p,
+             const OPWPoseBatch<FloatType>& poses,
+             const std::size_t n,
+             OPWSolutionBatch<FloatType>& solutions)
+{
+  // Terms that only depend on the robot
+  const FloatType kappa_2 = p.a2 * p.a2 + p.c3 * p.c3;
+  const FloatType c2_2 = p.c2 * p.c2;
+  const FloatType tmp9 = FloatType(2) * p.c2 * sqrtLane(kappa_2);
+  const FloatType tmp10 = atan2Lane(p.a2, p.c3);
+
+  // The two shoulder and four elbow configurations of the arm
+  alignas(64) FloatType theta1[2][OPW_BATCH_SIZE];
+  alignas(64) FloatType theta2[4][OPW_BATCH_SIZE];
+  alignas(64) FloatType theta3[4][OPW_BATCH_SIZE];
+
+  DESCARTES_OPW_BATCH_SIMD
+  for (std::size_t l = 0; l < n; ++l)
+  {
+    // Wrist center
+    const FloatType cx = poses.t[0][l] - p.c4 * poses.r[2][l];
+    const FloatType cy = poses.t[1][l] - p.c4 * poses.r[5][l];
+    const FloatType cz = poses.t[2][l] - p.c4 * poses.r[8][l];
+
+    const FloatType nx1 = sqrtLane(cx * cx + cy * cy - p.b * p.b) - p.a1;
+
+    const FloatType tmp1 = atan2Lane(cy, cx);
+    const FloatType tmp2 = atan2Lane(p.b, nx1 + p.a1);
+    theta1[0][l] = tmp1 - tmp2;
+    theta1[1][l] = tmp1 + tmp2 - FloatType(M_PI);
+
+    const FloatType tmp3 = cz - p.c1;
+    const FloatType s1_2 = nx1 * nx1 + tmp3 * tmp3;
+    const FloatType tmp4 = nx1 + FloatType(2) * p.a1;
+    const FloatType s2_2 = tmp4 * tmp4 + tmp3 * tmp3;
+
+    const FloatType tmp13 = acosLane((s1_2 + c2_2 - kappa_2) / (FloatType(2) * sqrtLane(s1_2) * p.c2));
+    const FloatType tmp14 = atan2Lane(nx1, tmp3);
+    theta2[0][l] = -tmp13 + tmp14;
+    theta2[1][l] = tmp13 + tmp14;
+
+    const FloatType tmp15 = acosLane((s2_2 + c2_2 - kappa_2) / (FloatType(2) * sqrtLane(s2_2) * p.c2));
+    const FloatType tmp16 = atan2Lane(tmp4, tmp3);
+    theta2[2][l] = -tmp15 - tmp16;
+    theta2[3][l] = tmp15 - tmp16;
+
+    const FloatType tmp11 = acosLane((s1_2 - c2_2 - kappa_2) / tmp9);
+    theta3[0][l] = tmp11 - tmp10;
+    theta3[1][l] = -tmp11 - tmp10;
+
+    const FloatType tmp12 = acosLane((s2_2 - c2_2 - kappa_2) / tmp9);
+    theta3[2][l] = tmp12 - tmp10;
+    theta3[3][l] = -tmp12 - tmp10;
+  }
+
+  for (std::size_t k = 0; k < 4; ++k)
+  {
+    DESCARTES_OPW_BATCH_SIMD
+    for (std::size_t l = 0; l < n; ++l)
+      solveWrist(p, poses, l, theta1[k / 2][l], theta2[k][l], theta3[k][l], solutions.q[k], solutions.q[k + 4]);
+  }
+}
+
+}  // namespace DESCARTES_OPW_BATCH_ISA
+}  // namespace opw_batch
+}  // namespace descartes_light
+
+#endif  // DESCARTES_OPW_IMPL_OPW_BATCH_KERNEL_HPP
@@ -0,0 +1,213 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2016, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef DESCARTES_OPW_IMPL_OPW_POLICY_KINEMATICS_HPP
+#define DESCARTES_OPW_IMPL_OPW_POLICY_KINEMATICS_HPP
+
+#include "descartes_opw/opw_policy_kinematics.h"
+#include <opw_kinematics/opw_utilities.h>
+#include <console_bridge/console.h>
+#include <algorithm>
+#include <array>
+#include <sstream>
+
+namespace descartes_light
+{
+template <typename FloatType>
+OPWBatchParameters<FloatType> toOPWBatchParameters(const opw_kinematics::Parameters<FloatType>& params)
+{
+  OPWBatchParameters<FloatType> batch_params;
+  batch_params.a1 = params.a1;
+  batch_params.a2 = params.a2;
+  batch_params.b = params.b;
+  batch_params.c1 = params.c1;
+  batch_params.c2 = params.c2;
+  batch_params.c3 = params.c3;
+  batch_params.c4 = params.c4;
+  for (std::size_t j = 0; j < 6; ++j)
+  {
+    batch_params.offsets[j] = params.offsets[j];
+    batch_params.sign_corrections[j] = static_cast<FloatType>(params.sign_corrections[j]);
+  }
+  return batch_params;
+}
+
+template <typename FloatType, typename IsValidPolicy, typename RedundantSolutionsPolicy>
+inline void appendOPWSolutions(FloatType* sols,
+                               const IsValidPolicy& is_valid,
+                               const RedundantSolutionsPolicy& redundant_sols,
+                               std::vector<FloatType>& solution_set)
+{
+  for (int i = 0; i < 8; i++)
+  {
+    FloatType* sol = sols + 6 * i;
+    if (!opw_kinematics::isValid(sol))
+      continue;
+
+    opw_kinematics::harmonizeTowardZero(sol);  // Modifies 'sol' in place
+
+    if (is_valid(sol))
+      solution_set.insert(end(solution_set), sol, sol + 6);
+
+    redundant_sols(static_cast<const FloatType*>(sol), [&is_valid, &solution_set](const FloatType* redundant_sol) {
+      if (is_valid(redundant_sol))
+        solution_set.insert(end(solution_set), redundant_sol, redundant_sol + 6);
+    });
+  }
+}
+
+template <typename FloatType, typename AppendFn>
+inline bool opwBatchIK(const OPWBatchParameters<FloatType>& params,
+                       const Eigen::Transform<FloatType, 3, Eigen::Isometry>& base_inv,
+                       const Eigen::Transform<FloatType, 3, Eigen::Isometry>& tool_inv,
+                       const Eigen::Transform<FloatType, 3, Eigen::Isometry>* poses,
+                       const std::size_t n,
+                       std::vector<FloatType>& solution_set,
+                       std::vector<std::size_t>& offsets,
+                       AppendFn append)
+{
+  OPWPoseBatch<FloatType> batch;
+  OPWSolutionBatch<FloatType> batch_sols;
+  std::array<FloatType, 6 * 8> sols;
+
+  offsets.resize(n + 1);
+  for (std::size_t begin = 0; begin < n; begin += OPW_BATCH_SIZE)
+  {
+    const std::size_t count = std::min(OPW_BATCH_SIZE, n - begin);
+    for (std::size_t l = 0; l < count; ++l)
+    {
+      const Eigen::Transform<FloatType, 3, Eigen::Isometry> tool_pose = base_inv * poses[begin + l] * tool_inv;
+      for (Eigen::Index r = 0; r < 3; ++r)
+      {
+        for (Eigen::Index c = 0; c < 3; ++c)
+          batch.r[3 * r + c][l] = tool_pose.linear()(r, c);
+        batch.t[r][l] = tool_pose.translation()(r);
+      }
+    }
+
+    opwInverseBatch(params, batch, count, batch_sols);
+
+    for (std::size_t l = 0; l < count; ++l)
+    {
+      for (std::size_t s = 0; s < 8; ++s)
+        for (std::size_t j = 0; j < 6; ++j)
+          sols[6 * s + j] = batch_sols.q[s][j][l];
+
+      offsets[begin + l] = solution_set.size();
+      append(sols.data());
+    }
+  }
+  offsets[n] = solution_set.size();
+
+  return offsets[n] != offsets[0];
+}
+
+template <typename FloatType, typename IsValidPolicy, typename RedundantSolutionsPolicy>
+OPWPolicyKinematics<FloatType, IsValidPolicy, RedundantSolutionsPolicy>::OPWPolicyKinematics(
+    const opw_kinematics::Parameters<FloatType>& params,
+    const Eigen::Transform<FloatType, 3, Eigen::Isometry>& world_to_base,
+    const Eigen::Transform<FloatType, 3, Eigen::Isometry>& tool0_to_tip,
+    const IsValidPolicy& is_valid,
+    const RedundantSolutionsPolicy& redundant_sols)
+  : params_(params)
+  , world_to_base_(world_to_base)
+  , tool0_to_tip_(tool0_to_tip)
+  , is_valid_(is_valid)
+  , redundant_sols_(redundant_sols)
+  , batch_params_(toOPWBatchParameters(params))
+{
+}
+
+template <typename FloatType, typename IsValidPolicy, typename RedundantSolutionsPolicy>
+bool OPWPolicyKinematics<FloatType, IsValidPolicy, RedundantSolutionsPolicy>::ik(
+    const Eigen::Transform<FloatType, 3, Eigen::Isometry>& p,
+    std::vector<FloatType>& solution_set) const
+{
+  std::array<FloatType, 6 * 8> sols;
+  opw_kinematics::inverse(params_, world_to_base_.inverse() * p * tool0_to_tip_.inverse(), sols.data());
+
+  appendOPWSolutions(sols.data(), is_valid_, redundant_sols_, solution_set);
+  return !solution_set.empty();
+}
+
+template <typename FloatType, typename IsValidPolicy, typename RedundantSolutionsPolicy>
+bool OPWPolicyKinematics<FloatType, IsValidPolicy, RedundantSolutionsPolicy>::ik(
+    const Eigen::Transform<FloatType, 3, Eigen::Isometry>* poses,
+    const std::size_t n,
+    std::vector<FloatType>& solution_set,
+    std::vector<std::size_t>& offsets) const
+{
+  return opwBatchIK(batch_params_,
+                    world_to_base_.inverse(),
+                    tool0_to_tip_.inverse(),
+                    poses,
+                    n,
+                    solution_set,
+                    offsets,
+                    [this, &solution_set](FloatType* sols) {
+                      appendOPWSolutions(sols, is_valid_, redundant_sols_, solution_set);
+                    });
+}
+
+template <typename FloatType, typename IsValidPolicy, typename RedundantSolutionsPolicy>
+bool OPWPolicyKinematics<FloatType, IsValidPolicy, RedundantSolutionsPolicy>::fk(
+    const FloatType* pose,
+    Eigen::Transform<FloatType, 3, Eigen::Isometry>& solution) const
+{
+  solution = opw_kinematics::forward<FloatType>(params_, pose);
+  solution = world_to_base_ * solution * tool0_to_tip_.inverse();
+  return true;
+}
+
+template <typename FloatType, typename IsValidPolicy, typename RedundantSolutionsPolicy>
+int OPWPolicyKinematics<FloatType, IsValidPolicy, RedundantSolutionsPolicy>::dof() const
+{
+  return 6;
+}
+
+template <typename FloatType, typename IsValidPolicy, typename RedundantSolutionsPolicy>
+void OPWPolicyKinematics<FloatType, IsValidPolicy, RedundantSolutionsPolicy>::analyzeIK(
+    const Eigen::Transform<FloatType, 3, Eigen::Isometry>& p) const
+{
+  Eigen::IOFormat CommaInitFmt(Eigen::StreamPrecision, Eigen::DontAlignCols, ", ", ", ", "", "", "AnalyzeIK: ", ";");
+
+  std::stringstream ss;
+  ss << p.matrix().format(CommaInitFmt);
+  CONSOLE_BRIDGE_logInform(ss.str().c_str());
+
+  const Eigen::Transform<FloatType, 3, Eigen::Isometry> tool_pose =
+      world_to_base_.inverse() * p * tool0_to_tip_.inverse();
+  std::array<FloatType, 6 * 8> sols;
+
+  std::vector<FloatType> solution_set;
+  opw_kinematics::inverse(params_, tool_pose, sols.data());
+  appendOPWSolutions(sols.data(), AllSolutionsValid(), NoRedundantSolutions(), solution_set);
+  ss.str("");
+  ss << "\tSampling without policies, found solutions: " << solution_set.size() / 6;
+  CONSOLE_BRIDGE_logInform(ss.str().c_str());
+
+  solution_set.clear();
+  opw_kinematics::inverse(params_, tool_pose, sols.data());
+  appendOPWSolutions(sols.data(), is_valid_, redundant_sols_, solution_set);
+  ss.str("");
+  ss << "\tSampling with policies, found solutions: " << solution_set.size() / 6;
+  CONSOLE_BRIDGE_logInform(ss.str().c_str());
+}
+
+}  // namespace descartes_light
+
+#endif  // DESCARTES_OPW_IMPL_OPW_POLICY_KINEMATICS_HPP
@@ -0,0 +1,87 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2016, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef DESCARTES_OPW_OPW_BATCH_H
+#define DESCARTES_OPW_OPW_BATCH_H
+
+#include <descartes_light/visibility_control.h>
+#include <cstddef>
+
+// This header is included by translation units built for AVX2/AVX-512 while the rest of the library is built with
+// -mno-avx, so it must not include Eigen or anything else that defines inline code shared with the rest of the library.
+
+namespace descartes_light
+{
+/** @brief The maximum number of poses solved by a single call to opwInverseBatch() */
+static const std::size_t OPW_BATCH_SIZE = 16;
+
+/** @brief The OPW parameters in the plain form used by the batched solver, see opw_kinematics::Parameters */
+template <typename FloatType>
+struct OPWBatchParameters
+{
+  FloatType a1, a2, b, c1, c2, c3, c4;
+  FloatType offsets[6];
+  FloatType sign_corrections[6];
+};
+
+/** @brief Up to OPW_BATCH_SIZE poses of tool0 in the robot base frame, stored as a structure of arrays */
+template <typename FloatType>
+struct OPWPoseBatch
+{
+  alignas(64) FloatType r[9][OPW_BATCH_SIZE];  // rotation, r[3 * row + col][pose]
+  alignas(64) FloatType t[3][OPW_BATCH_SIZE];  // translation, t[axis][pose]
+};
+
+/** @brief The 8 candidate solutions of each pose of an OPWPoseBatch, stored as a structure of arrays */
+template <typename FloatType>
+struct OPWSolutionBatch
+{
+  alignas(64) FloatType q[8][6][OPW_BATCH_SIZE];  // q[solution][joint][pose]
+};
+
+/**
+ * @brief Solves the OPW inverse kinematics of 'n' poses at once
+ *
+ * This produces the same 8 candidate solutions per pose, in the same order, as opw_kinematics::inverse(). Unreachable
+ * candidates are NaN. The poses are processed in SIMD lanes; the widest instruction set supported by the CPU (SSE2,
+ * AVX2 or AVX-512) is selected the first time this is called.
+ *
+ * @param params The kinematic parameters of the robot
+ * @param poses The poses to solve
+ * @param n The number of poses, at most OPW_BATCH_SIZE
+ * @param solutions The candidate solutions of each pose
+ */
+template <typename FloatType>
+DESCARTES_PUBLIC void opwInverseBatch(const OPWBatchParameters<FloatType>& params,
+                                      const OPWPoseBatch<FloatType>& poses,
+                                      std::size_t n,
+                                      OPWSolutionBatch<FloatType>& solutions);
+
+/** @brief The instruction set used by opwInverseBatch() on this CPU: "avx512", "avx2" or "sse2" */
+DESCARTES_PUBLIC const char* opwBatchInstructionSet();
+
+/**
+ * @brief Makes opwInverseBatch() use the given instruction set instead of the widest one, e.g. to compare the kernels
+ * @param isa "avx512", "avx2" or "sse2"
+ * @return False, leaving the selection unchanged, if the library was built without that kernel or the CPU does not
+ * support it
+ */
+DESCARTES_PUBLIC bool setOpwBatchInstructionSet(const char* isa);
+
+}  // namespace descartes_light
+
+#endif  // DESCARTES_OPW_OPW_BATCH_H
@@ -0,0 +1,117 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2016, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef DESCARTES_OPW_OPW_POLICY_KINEMATICS_H
+#define DESCARTES_OPW_OPW_POLICY_KINEMATICS_H
+
+#include <descartes_light/visibility_control.h>
+#include <descartes_light/interface/kinematics_interface.h>
+#include <descartes_light/utils.h>
+#include <descartes_opw/opw_batch.h>
+#include <opw_kinematics/opw_kinematics.h>
+
+namespace descartes_light
+{
+/**
+ * @brief OPW kinematics with the solution filtering and redundant solution expansion fixed at compile time
+ *
+ * This behaves like OPWKinematics constructed with the equivalent IsValidFn and GetRedundantSolutionsFn, but the
+ * policies (see AllSolutionsValid, WithinLimits, NoRedundantSolutions and RedundantSolutionsWithinLimits in utils.h)
+ * are inlined and redundant solutions are written straight into the caller's solution set. Once the solution set has
+ * grown to its working size, ik() does not allocate.
+ *
+ * The library instantiates the default policies, WithinLimits alone and OPWJointLimitedKinematics. Other policies need
+ * descartes_opw/impl/opw_policy_kinematics.hpp to be included.
+ */
+template <typename FloatType,
+          typename IsValidPolicy = AllSolutionsValid,
+          typename RedundantSolutionsPolicy = NoRedundantSolutions>
+class OPWPolicyKinematics : public KinematicsInterface<FloatType>
+{
+public:
+  OPWPolicyKinematics(const opw_kinematics::Parameters<FloatType>& params,
+                      const Eigen::Transform<FloatType, 3, Eigen::Isometry>& world_to_base,
+                      const Eigen::Transform<FloatType, 3, Eigen::Isometry>& tool0_to_tip,
+                      const IsValidPolicy& is_valid = IsValidPolicy(),
+                      const RedundantSolutionsPolicy& redundant_sols = RedundantSolutionsPolicy());
+
+  bool ik(const Eigen::Transform<FloatType, 3, Eigen::Isometry>& p,
+          std::vector<FloatType>& solution_set) const override;
+
+  /** @brief Batched IK with the vectorized solver, see OPWKinematics */
+  bool ik(const Eigen::Transform<FloatType, 3, Eigen::Isometry>* poses,
+          const std::size_t n,
+          std::vector<FloatType>& solution_set,
+          std::vector<std::size_t>& offsets) const override;
+
+  bool fk(const FloatType* pose, Eigen::Transform<FloatType, 3, Eigen::Isometry>& solution) const override;
+
+  int dof() const override;
+
+  void analyzeIK(const Eigen::Transform<FloatType, 3, Eigen::Isometry>& p) const override;
+
+private:
+  opw_kinematics::Parameters<FloatType> params_;
+  Eigen::Transform<FloatType, 3, Eigen::Isometry> world_to_base_;
+  Eigen::Transform<FloatType, 3, Eigen::Isometry> tool0_to_tip_;
+  IsValidPolicy is_valid_;
+  RedundantSolutionsPolicy redundant_sols_;
+  OPWBatchParameters<FloatType> batch_params_;
+};
+
+/** @brief OPW kinematics limited to the given joint limits, including the redundant solutions within them */
+template <typename FloatType>
+using OPWJointLimitedKinematics =
+    OPWPolicyKinematics<FloatType, WithinLimits<FloatType, 6>, RedundantSolutionsWithinLimits<FloatType, 6>>;
+
+using OPWJointLimitedKinematicsF = OPWJointLimitedKinematics<float>;
+using OPWJointLimitedKinematicsD = OPWJointLimitedKinematics<double>;
+
+/** @brief Converts OPW parameters to the form used by opwInverseBatch() */
+template <typename FloatType>
+OPWBatchParameters<FloatType> toOPWBatchParameters(const opw_kinematics::Parameters<FloatType>& params);
+
+/**
+ * @brief Filters the 8 candidate solutions of opw_kinematics::inverse() and appends the valid ones, each followed by
+ * its valid redundant solutions, to the solution set
+ * @param sols The 8 candidate solutions, harmonized toward zero in place
+ */
+template <typename FloatType, typename IsValidPolicy, typename RedundantSolutionsPolicy>
+inline void appendOPWSolutions(FloatType* sols,
+                               const IsValidPolicy& is_valid,
+                               const RedundantSolutionsPolicy& redundant_sols,
+                               std::vector<FloatType>& solution_set);
+
+/**
+ * @brief Implements the batched KinematicsInterface::ik() on top of opwInverseBatch()
+ * @param base_inv The inverse of the world to robot base transform
+ * @param tool_inv The inverse of the tool0 to tip transform
+ * @param append Called as append(FloatType* sols) with the 8 candidate solutions of each pose, in order
+ */
+template <typename FloatType, typename AppendFn>
+inline bool opwBatchIK(const OPWBatchParameters<FloatType>& params,
+                       const Eigen::Transform<FloatType, 3, Eigen::Isometry>& base_inv,
+                       const Eigen::Transform<FloatType, 3, Eigen::Isometry>& tool_inv,
+                       const Eigen::Transform<FloatType, 3, Eigen::Isometry>* poses,
+                       const std::size_t n,
+                       std::vector<FloatType>& solution_set,
+                       std::vector<std::size_t>& offsets,
+                       AppendFn append);
+
+}  // namespace descartes_light
+
+#endif  // DESCARTES_OPW_OPW_POLICY_KINEMATICS_H
@@ -0,0 +1,164 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2016, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#define DESCARTES_OPW_BATCH_ISA sse2
+#include "descartes_opw/impl/opw_batch_kernel.hpp"
+#include <atomic>
+#include <cstring>
+
+namespace descartes_light
+{
+namespace opw_batch
+{
+// Defined in the translation units built for the wider instruction sets
+#ifdef DESCARTES_OPW_BATCH_AVX2
+namespace avx2
+{
+template <typename FloatType>
+void inverse(const OPWBatchParameters<FloatType>& p,
+             const OPWPoseBatch<FloatType>& poses,
+             const std::size_t n,
+             OPWSolutionBatch<FloatType>& solutions);
+}  // namespace avx2
+#endif
+
+#ifdef DESCARTES_OPW_BATCH_AVX512
+namespace avx512
+{
+template <typename FloatType>
+void inverse(const OPWBatchParameters<FloatType>& p,
+             const OPWPoseBatch<FloatType>& poses,
+             const std::size_t n,
+             OPWSolutionBatch<FloatType>& solutions);
+}  // namespace avx512
+#endif
+
+enum class InstructionSet
+{
+  SSE2,
+  AVX2,
+  AVX512
+};
+
+static bool supported(const InstructionSet isa)
+{
+  switch (isa)
+  {
+    case InstructionSet::AVX512:
+#ifdef DESCARTES_OPW_BATCH_AVX512
+      return __builtin_cpu_supports("avx512f");
+#else
+      return false;
+#endif
+    case InstructionSet::AVX2:
+#ifdef DESCARTES_OPW_BATCH_AVX2
+      return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+      return false;
+#endif
+    default:
+      return true;
+  }
+}
+
+static InstructionSet detectInstructionSet()
+{
+  if (supported(InstructionSet::AVX512))
+    return InstructionSet::AVX512;
+  if (supported(InstructionSet::AVX2))
+    return InstructionSet::AVX2;
+  return InstructionSet::SSE2;
+}
+
+static std::atomic<InstructionSet>& selectedInstructionSet()
+{
+  static std::atomic<InstructionSet> isa(detectInstructionSet());
+  return isa;
+}
+
+static InstructionSet instructionSet() { return selectedInstructionSet().load(std::memory_order_relaxed); }
+}  // namespace opw_batch
+
+template <typename FloatType>
+void opwInverseBatch(const OPWBatchParameters<FloatType>& params,
+                     const OPWPoseBatch<FloatType>& poses,
+                     std::size_t n,
+                     OPWSolutionBatch<FloatType>& solutions)
+{
+  if (n > OPW_BATCH_SIZE)
+    n = OPW_BATCH_SIZE;
+
+  switch (opw_batch::instructionSet())
+  {
+#ifdef DESCARTES_OPW_BATCH_AVX512
+    case opw_batch::InstructionSet::AVX512:
+      opw_batch::avx512::inverse(params, poses, n, solutions);
+      return;
+#endif
+#ifdef DESCARTES_OPW_BATCH_AVX2
+    case opw_batch::InstructionSet::AVX2:
+      opw_batch::avx2::inverse(params, poses, n, solutions);
+      return;
+#endif
+    default:
+      opw_batch::sse2::inverse(params, poses, n, solutions);
+  }
+}
+
+const char* opwBatchInstructionSet()
+{
+  switch (opw_batch::instructionSet())
+  {
+    case opw_batch::InstructionSet::AVX512:
+      return "avx512";
+    case opw_batch::InstructionSet::AVX2:
+      return "avx2";
+    default:
+      return "sse2";
+  }
+}
+
+bool setOpwBatchInstructionSet(const char* isa)
+{
+  opw_batch::InstructionSet selected;
+  if (std::strcmp(isa, "avx512") == 0)
+    selected = opw_batch::InstructionSet::AVX512;
+  else if (std::strcmp(isa, "avx2") == 0)
+    selected = opw_batch::InstructionSet::AVX2;
+  else if (std::strcmp(isa, "sse2") == 0)
+    selected = opw_batch::InstructionSet::SSE2;
+  else
+    return false;
+
+  if (!opw_batch::supported(selected))
+    return false;
+
+  opw_batch::selectedInstructionSet().store(selected, std::memory_order_relaxed);
+  return true;
+}
+
+// Explicit template instantiation
+template DESCARTES_PUBLIC void opwInverseBatch<float>(const OPWBatchParameters<float>& params,
+                                                      const OPWPoseBatch<float>& poses,
+                                                      std::size_t n,
+                                                      OPWSolutionBatch<float>& solutions);
+template DESCARTES_PUBLIC void opwInverseBatch<double>(const OPWBatchParameters<double>& params,
+                                                       const OPWPoseBatch<double>& poses,
+                                                       std::size_t n,
+                                                       OPWSolutionBatch<double>& solutions);
+
+}  // namespace descartes_light
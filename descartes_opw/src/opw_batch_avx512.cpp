@@ -0,0 +1,40 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2016, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Built with AVX512 enabled; only called after opwInverseBatch() has checked that the CPU supports it
+#define DESCARTES_OPW_BATCH_ISA avx512
+#include "descartes_opw/impl/opw_batch_kernel.hpp"
+
+namespace descartes_light
+{
+namespace opw_batch
+{
+namespace avx512
+{
+// Explicit template instantiation
+template void inverse<float>(const OPWBatchParameters<float>& p,
+                             const OPWPoseBatch<float>& poses,
+                             const std::size_t n,
+                             OPWSolutionBatch<float>& solutions);
+template void inverse<double>(const OPWBatchParameters<double>& p,
+                              const OPWPoseBatch<double>& poses,
+                              const std::size_t n,
+                              OPWSolutionBatch<double>& solutions);
+}  // namespace avx512
+}  // namespace opw_batch
+}  // namespace descartes_light
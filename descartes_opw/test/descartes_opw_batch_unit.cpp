@@ -0,0 +1,260 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2016, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <descartes_opw/opw_batch.h>
+#include <descartes_opw/impl/opw_policy_kinematics.hpp>
+#include <opw_kinematics/opw_kinematics.h>
+
+using namespace descartes_light;
+
+// Compares the batched kernel of every instruction set the CPU supports with opw_kinematics::inverse(), candidate by
+// candidate, on the tool poses of random joint values.
+
+namespace
+{
+/** @brief A KUKA KR 6 R700 sixx */
+template <typename FloatType>
+opw_kinematics::Parameters<FloatType> makeKukaKr6()
+{
+  opw_kinematics::Parameters<FloatType> p;
+  p.a1 = FloatType(0.025);
+  p.a2 = FloatType(-0.035);
+  p.b = FloatType(0.0);
+  p.c1 = FloatType(0.400);
+  p.c2 = FloatType(0.315);
+  p.c3 = FloatType(0.365);
+  p.c4 = FloatType(0.080);
+
+  const FloatType offsets[6] = { 0, FloatType(-M_PI / 2), 0, 0, 0, 0 };
+  const signed char sign_corrections[6] = { -1, 1, 1, -1, 1, -1 };
+  for (std::size_t j = 0; j < 6; ++j)
+  {
+    p.offsets[j] = offsets[j];
+    p.sign_corrections[j] = sign_corrections[j];
+  }
+  return p;
+}
+
+/** @brief A robot whose forearm is offset from the plane of the arm, b != 0, which takes separate branches in theta1 */
+template <typename FloatType>
+opw_kinematics::Parameters<FloatType> makeLateralOffsetRobot()
+{
+  opw_kinematics::Parameters<FloatType> p;
+  p.a1 = FloatType(0.15);
+  p.a2 = FloatType(-0.11);
+  p.b = FloatType(0.05);
+  p.c1 = FloatType(0.6);
+  p.c2 = FloatType(0.7);
+  p.c3 = FloatType(0.8);
+  p.c4 = FloatType(0.1);
+
+  const FloatType offsets[6] = { FloatType(0.1), FloatType(-M_PI / 2), FloatType(0.2), 0, 0, 0 };
+  for (std::size_t j = 0; j < 6; ++j)
+  {
+    p.offsets[j] = offsets[j];
+    p.sign_corrections[j] = 1;
+  }
+  return p;
+}
+
+/** @brief Tool poses of random joint values; with 'wrist_singular' set, joint 5 is at its singularity */
+template <typename FloatType>
+std::vector<Eigen::Transform<FloatType, 3, Eigen::Isometry>,
+            Eigen::aligned_allocator<Eigen::Transform<FloatType, 3, Eigen::Isometry>>>
+makePoses(const opw_kinematics::Parameters<FloatType>& params, const std::size_t n, const bool wrist_singular)
+{
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<double> joint(-3.0, 3.0);
+
+  std::vector<Eigen::Transform<FloatType, 3, Eigen::Isometry>,
+              Eigen::aligned_allocator<Eigen::Transform<FloatType, 3, Eigen::Isometry>>>
+      poses(n);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    FloatType q[6];
+    for (FloatType& qj : q)
+      qj = static_cast<FloatType>(joint(rng));
+    if (wrist_singular)
+      q[4] = params.offsets[4] * params.sign_corrections[4];
+
+    poses[i] = opw_kinematics::forward<FloatType>(params, q);
+
+    // Every seventh pose is out of reach, so that all its candidates are NaN
+    if (i % 7 == 6)
+      poses[i].translation() *= FloatType(3.0);
+  }
+  return poses;
+}
+
+bool isFinite(const double* q, const std::size_t first, const std::size_t last)
+{
+  for (std::size_t j = first; j < last; ++j)
+    if (!std::isfinite(q[j]))
+      return false;
+  return true;
+}
+
+/**
+ * @brief Solves the poses in batches of every size up to OPW_BATCH_SIZE with the selected kernel and compares the
+ * candidates with opw_kinematics::inverse()
+ *
+ * Away from the singularities the same candidates must be reachable and every joint must agree within
+ * 'joint_tolerance'. At the wrist singularity theta5 is computed as the square root of a rounding error, which either
+ * solver may round to NaN, and theta4 and theta6 are both computed from such rounding errors. There the arm joints
+ * must still agree within 'joint_tolerance', and theta5 within a few square roots of the machine epsilon when both
+ * solvers find it; theta4 and theta6 are not compared.
+ */
+template <typename FloatType>
+void compareWithScalar(const opw_kinematics::Parameters<FloatType>& params,
+                       const bool wrist_singular,
+                       const double joint_tolerance)
+{
+  const double wrist_tolerance = 8 * std::sqrt(double(std::numeric_limits<FloatType>::epsilon()));
+
+  const OPWBatchParameters<FloatType> batch_params = toOPWBatchParameters(params);
+  const auto poses = makePoses(params, 4000, wrist_singular);
+
+  OPWPoseBatch<FloatType> batch;
+  OPWSolutionBatch<FloatType> batch_sols;
+  std::size_t n_compared = 0;
+  for (std::size_t begin = 0, n = 1; begin < poses.size(); begin += n, n = n % OPW_BATCH_SIZE + 1)
+  {
+    const std::size_t count = std::min(n, poses.size() - begin);
+    for (std::size_t l = 0; l < count; ++l)
+    {
+      for (Eigen::Index r = 0; r < 3; ++r)
+      {
+        for (Eigen::Index c = 0; c < 3; ++c)
+          batch.r[3 * r + c][l] = poses[begin + l].linear()(r, c);
+        batch.t[r][l] = poses[begin + l].translation()(r);
+      }
+    }
+
+    opwInverseBatch(batch_params, batch, count, batch_sols);
+
+    for (std::size_t l = 0; l < count; ++l)
+    {
+      FloatType scalar_sols[6 * 8];
+      opw_kinematics::inverse(params, poses[begin + l], scalar_sols);
+
+      for (std::size_t k = 0; k < 8; ++k)
+      {
+        double expected[6];
+        double actual[6];
+        for (std::size_t j = 0; j < 6; ++j)
+        {
+          expected[j] = double(scalar_sols[6 * k + j]);
+          actual[j] = double(batch_sols.q[k][j][l]);
+        }
+
+        const std::size_t n_checked = wrist_singular ? 3 : 6;
+        ASSERT_EQ(isFinite(expected, 0, n_checked), isFinite(actual, 0, n_checked))
+            << "pose " << begin + l << ", candidate " << k;
+        if (!isFinite(expected, 0, n_checked))
+          continue;
+
+        for (std::size_t j = 0; j < n_checked; ++j)
+        {
+          EXPECT_NEAR(std::remainder(actual[j] - expected[j], 2 * M_PI), 0.0, joint_tolerance)
+              << "pose " << begin + l << ", candidate " << k << ", joint " << j;
+        }
+
+        if (wrist_singular && std::isfinite(expected[4]) && std::isfinite(actual[4]))
+        {
+          EXPECT_NEAR(actual[4], expected[4], wrist_tolerance) << "pose " << begin + l << ", candidate " << k;
+        }
+
+        ++n_compared;
+      }
+    }
+  }
+
+  EXPECT_GT(n_compared, poses.size());
+}
+
+/** @brief Runs 'compare' once with each instruction set the CPU supports, then restores the default selection */
+template <typename CompareFn>
+void forEachInstructionSet(CompareFn compare)
+{
+  const std::string default_isa = opwBatchInstructionSet();
+  for (const char* isa : { "sse2", "avx2", "avx512" })
+  {
+    if (!setOpwBatchInstructionSet(isa))
+    {
+      std::cout << "Skipping " << isa << ", not supported by this build or CPU" << std::endl;
+      continue;
+    }
+
+    SCOPED_TRACE(isa);
+    ASSERT_EQ(std::string(isa), opwBatchInstructionSet());
+    compare();
+  }
+  setOpwBatchInstructionSet(default_isa.c_str());
+}
+}  // namespace
+
+// The joint tolerances in radians: double precision agrees to 3e-10, single precision to about 4e-4 where acos() is
+// ill-conditioned, near the edges of the workspace
+static const double DOUBLE_JOINT_TOLERANCE = 3e-10;
+static const double FLOAT_JOINT_TOLERANCE = 1e-3;
+
+TEST(OPWBatchUnit, DoubleMatchesScalar)
+{
+  forEachInstructionSet([] {
+    compareWithScalar(makeKukaKr6<double>(), false, DOUBLE_JOINT_TOLERANCE);
+    compareWithScalar(makeLateralOffsetRobot<double>(), false, DOUBLE_JOINT_TOLERANCE);
+  });
+}
+
+TEST(OPWBatchUnit, FloatMatchesScalar)
+{
+  forEachInstructionSet([] {
+    compareWithScalar(makeKukaKr6<float>(), false, FLOAT_JOINT_TOLERANCE);
+    compareWithScalar(makeLateralOffsetRobot<float>(), false, FLOAT_JOINT_TOLERANCE);
+  });
+}
+
+TEST(OPWBatchUnit, DoubleMatchesScalarAtWristSingularity)
+{
+  forEachInstructionSet([] {
+    compareWithScalar(makeKukaKr6<double>(), true, DOUBLE_JOINT_TOLERANCE);
+    compareWithScalar(makeLateralOffsetRobot<double>(), true, DOUBLE_JOINT_TOLERANCE);
+  });
+}
+
+TEST(OPWBatchUnit, FloatMatchesScalarAtWristSingularity)
+{
+  forEachInstructionSet([] {
+    compareWithScalar(makeKukaKr6<float>(), true, FLOAT_JOINT_TOLERANCE);
+    compareWithScalar(makeLateralOffsetRobot<float>(), true, FLOAT_JOINT_TOLERANCE);
+  });
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,98 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2016, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef DESCARTES_SAMPLERS_EVALUATORS_COLLISION_EDGE_EVALUATOR_H
+#define DESCARTES_SAMPLERS_EVALUATORS_COLLISION_EDGE_EVALUATOR_H
+
+#include <descartes_light/visibility_control.h>
+#include <descartes_light/interface/collision_interface.h>
+#include <descartes_light/interface/edge_evaluator.h>
+
+namespace descartes_light
+{
+/**
+ * @brief Wraps an edge evaluator and removes the edges whose motion is in collision
+ *
+ * The motion of an edge is checked at joint states interpolated between its vertices, at most 'resolution' apart in
+ * every joint; the vertices themselves are left to the samplers. The states are checked in bisection order, the
+ * midpoint first, then the quarter points and so on, so an edge through an obstacle usually fails on its first check.
+ *
+ * The out edges of a start vertex are checked together, in rounds of one CollisionInterface::validateBatch() call
+ * each: the first round checks the midpoint of every edge, every later round twice as many states of the edges still
+ * valid. The bisection orders are computed once per number of states and shared by all edges. The states next to the
+ * start vertex are close for all of its edges; wrapping the collision interface in a CachedCollision shares their
+ * checks as well.
+ *
+ * With 'lazy' set, evaluate() only returns the edges of the wrapped evaluator and leaves the checks to the solver,
+ * which runs them on the edges of the paths it finds, see EdgeEvaluator::hasDeferredChecks(). Only the edges a search
+ * actually uses are then checked. Combined with Solver::setLazyEdges(), most edges are never even evaluated.
+ */
+template <typename FloatType>
+class CollisionEdgeEvaluator : public EdgeEvaluator<FloatType>
+{
+public:
+  /**
+   * @param dof The number of joints
+   * @param evaluator The evaluator whose edges are checked, and whose costs are kept
+   * @param collision The collision interface the interpolated states are checked with
+   * @param resolution The largest step of any joint between consecutive checked states
+   * @param lazy Whether to leave the checks to the solver, see the class description
+   */
+  CollisionEdgeEvaluator(int dof,
+                         typename EdgeEvaluator<FloatType>::Ptr evaluator,
+                         typename CollisionInterface<FloatType>::Ptr collision,
+                         const FloatType resolution,
+                         const bool lazy = true);
+
+  bool evaluate(const Rung_<FloatType>& from,
+                const Rung_<FloatType>& to,
+                std::vector<typename LadderGraph<FloatType>::EdgeList>& edges) override;
+
+  /** @brief A wrapper of a clone of the wrapped evaluator, or nullptr if the wrapped evaluator is shared */
+  std::shared_ptr<EdgeEvaluator<FloatType>> clone() const override;
+
+  bool hasDeferredChecks() const override;
+
+  bool isValid(const FloatType* from, const FloatType* to, const std::size_t dof) override;
+
+protected:
+  std::size_t dof_;
+  typename EdgeEvaluator<FloatType>::Ptr evaluator_;
+  typename CollisionInterface<FloatType>::Ptr collision_;
+  FloatType resolution_;
+  bool lazy_;
+
+  /**
+   * @brief Checks the motions from one start state to n end states, in rounds over all motions, see the class
+   * description
+   * @param valid Set to 1 for each motion free of collision and 0 for the others, n entries
+   */
+  void checkMotions(const FloatType* from, const FloatType* const* to, const std::size_t n, char* valid);
+
+  /** @brief The number of segments the motion between two states is split into, at least one */
+  std::size_t segments(const FloatType* from, const FloatType* to) const;
+
+  /** @brief The interior steps 1 .. n_segments - 1 in bisection order, cached per thread */
+  static const std::vector<std::size_t>& bisectionOrder(const std::size_t n_segments);
+};
+
+using CollisionEdgeEvaluatorF = CollisionEdgeEvaluator<float>;
+using CollisionEdgeEvaluatorD = CollisionEdgeEvaluator<double>;
+
+}  // namespace descartes_light
+
+#endif  // DESCARTES_SAMPLERS_EVALUATORS_COLLISION_EDGE_EVALUATOR_H
@@ -27,13 +27,19 @@ template <typename FloatType>
 class DistanceEdgeEvaluator : public EdgeEvaluator<FloatType>
 {
 public:
-  DistanceEdgeEvaluator(const std::vector<FloatType>& velocity_limits);
+  /**
+   * @param velocity_limits The velocity limit of each joint
+   * @param use_matrix_product Computes the costs of each pair of rungs through matrix products, see
+   * jointDistanceEdgesProduct(). Faster for large rungs; the costs differ from the direct sums by rounding.
+   */
+  DistanceEdgeEvaluator(const std::vector<FloatType>& velocity_limits, const bool use_matrix_product = false);
 
   bool evaluate(const Rung_<FloatType>& from,
                 const Rung_<FloatType>& to,
                 std::vector<typename LadderGraph<FloatType>::EdgeList>& edges) override;
 
   std::vector<FloatType> velocity_limits_;
+  bool use_matrix_product_;
 };
 
 using DistanceEdgeEvaluatorF = DistanceEdgeEvaluator<float>;
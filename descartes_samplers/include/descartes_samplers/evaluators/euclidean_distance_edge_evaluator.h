@@ -27,7 +27,11 @@ template <typename FloatType>
 class EuclideanDistanceEdgeEvaluator : public EdgeEvaluator<FloatType>
 {
 public:
-  EuclideanDistanceEdgeEvaluator(int dof);
+  /**
+   * @param use_matrix_product Computes the costs of each pair of rungs through matrix products, see
+   * jointDistanceEdgesProduct(). Faster for large rungs; the costs differ from the direct sums by rounding.
+   */
+  EuclideanDistanceEdgeEvaluator(int dof, const bool use_matrix_product = false);
 
   bool evaluate(const Rung_<FloatType>& from,
                 const Rung_<FloatType>& to,
@@ -35,6 +39,7 @@ public:
 
 protected:
   std::size_t dof_;
+  bool use_matrix_product_;
 };
 
 using EuclideanDistanceEdgeEvaluatorF = EuclideanDistanceEdgeEvaluator<float>;
@@ -0,0 +1,207 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2016, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef DESCARTES_SAMPLERS_EVALUATORS_COLLISION_EDGE_EVALUATOR_HPP
+#define DESCARTES_SAMPLERS_EVALUATORS_COLLISION_EDGE_EVALUATOR_HPP
+
+#include <descartes_samplers/evaluators/collision_edge_evaluator.h>
+#include <descartes_light/thread_clones.h>
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <utility>
+
+namespace descartes_light
+{
+template <typename FloatType>
+CollisionEdgeEvaluator<FloatType>::CollisionEdgeEvaluator(int dof,
+                                                          typename EdgeEvaluator<FloatType>::Ptr evaluator,
+                                                          typename CollisionInterface<FloatType>::Ptr collision,
+                                                          const FloatType resolution,
+                                                          const bool lazy)
+  : dof_(static_cast<std::size_t>(dof))
+  , evaluator_(std::move(evaluator))
+  , collision_(std::move(collision))
+  , resolution_(resolution)
+  , lazy_(lazy)
+{
+}
+
+template <typename FloatType>
+bool CollisionEdgeEvaluator<FloatType>::evaluate(const Rung_<FloatType>& from,
+                                                 const Rung_<FloatType>& to,
+                                                 std::vector<typename LadderGraph<FloatType>::EdgeList>& edges)
+{
+  if (!ThreadClones::local(evaluator_)->evaluate(from, to, edges))
+    return false;
+
+  if (lazy_ || collision_ == nullptr)
+    return true;
+
+  thread_local std::vector<const FloatType*> ends;
+  thread_local std::vector<char> valid;
+
+  bool found = false;
+  for (std::size_t i = 0; i < edges.size(); ++i)
+  {
+    auto& vertex_edges = edges[i];
+    ends.clear();
+    for (const auto& edge : vertex_edges)
+      ends.push_back(to.data.data() + dof_ * edge.idx);
+
+    valid.resize(ends.size());
+    checkMotions(from.data.data() + dof_ * i, ends.data(), ends.size(), valid.data());
+
+    std::size_t n_valid = 0;
+    for (std::size_t e = 0; e < vertex_edges.size(); ++e)
+      if (valid[e])
+        vertex_edges[n_valid++] = vertex_edges[e];
+    vertex_edges.resize(n_valid);
+
+    found = found || n_valid != 0;
+  }
+
+  return found;
+}
+
+template <typename FloatType>
+std::shared_ptr<EdgeEvaluator<FloatType>> CollisionEdgeEvaluator<FloatType>::clone() const
+{
+  // The collision interface is cloned per thread by checkMotions(), see ThreadClones::local()
+  auto evaluator = evaluator_->clone();
+  if (!evaluator)
+    return nullptr;
+
+  return std::make_shared<CollisionEdgeEvaluator<FloatType>>(
+      static_cast<int>(dof_), std::move(evaluator), collision_, resolution_, lazy_);
+}
+
+template <typename FloatType>
+bool CollisionEdgeEvaluator<FloatType>::hasDeferredChecks() const
+{
+  return lazy_ && collision_ != nullptr;
+}
+
+template <typename FloatType>
+bool CollisionEdgeEvaluator<FloatType>::isValid(const FloatType* from, const FloatType* to, const std::size_t /*dof*/)
+{
+  if (collision_ == nullptr)
+    return true;
+
+  char valid;
+  checkMotions(from, &to, 1, &valid);
+  return valid != 0;
+}
+
+template <typename FloatType>
+void CollisionEdgeEvaluator<FloatType>::checkMotions(const FloatType* from,
+                                                     const FloatType* const* to,
+                                                     const std::size_t n,
+                                                     char* valid)
+{
+  thread_local std::vector<std::size_t> n_segments;
+  thread_local std::vector<FloatType> states;
+  thread_local std::vector<std::size_t> owners;
+  thread_local std::vector<char> states_valid;
+
+  n_segments.resize(n);
+  for (std::size_t e = 0; e < n; ++e)
+  {
+    valid[e] = 1;
+    n_segments[e] = segments(from, to[e]);
+  }
+
+  CollisionInterface<FloatType>* collision = ThreadClones::local(collision_);
+
+  // Round r checks the states [begin, begin + round) of the bisection order of each motion still valid
+  for (std::size_t begin = 0, round = 1;; begin += round, round *= 2)
+  {
+    states.clear();
+    owners.clear();
+    for (std::size_t e = 0; e < n; ++e)
+    {
+      if (!valid[e] || n_segments[e] <= begin + 1)
+        continue;
+
+      const auto& order = bisectionOrder(n_segments[e]);
+      const std::size_t end = std::min(begin + round, order.size());
+      const FloatType scale = static_cast<FloatType>(1.0) / static_cast<FloatType>(n_segments[e]);
+      for (std::size_t k = begin; k < end; ++k)
+      {
+        const FloatType t = static_cast<FloatType>(order[k]) * scale;
+        for (std::size_t j = 0; j < dof_; ++j)
+          states.push_back(from[j] + t * (to[e][j] - from[j]));
+        owners.push_back(e);
+      }
+    }
+
+    if (owners.empty())
+      return;
+
+    states_valid.resize(owners.size());
+    if (collision->validateBatch(states.data(), dof_, owners.size(), states_valid.data()) == owners.size())
+      continue;
+
+    for (std::size_t i = 0; i < owners.size(); ++i)
+      if (!states_valid[i])
+        valid[owners[i]] = 0;
+  }
+}
+
+template <typename FloatType>
+std::size_t CollisionEdgeEvaluator<FloatType>::segments(const FloatType* from, const FloatType* to) const
+{
+  FloatType max_delta = 0;
+  for (std::size_t j = 0; j < dof_; ++j)
+    max_delta = std::max(max_delta, std::abs(to[j] - from[j]));
+
+  return std::max<std::size_t>(static_cast<std::size_t>(std::ceil(max_delta / resolution_)), 1);
+}
+
+template <typename FloatType>
+const std::vector<std::size_t>& CollisionEdgeEvaluator<FloatType>::bisectionOrder(const std::size_t n_segments)
+{
+  thread_local std::vector<std::vector<std::size_t>> orders;
+  if (orders.size() <= n_segments)
+    orders.resize(n_segments + 1);
+
+  auto& order = orders[n_segments];
+  if (!order.empty() || n_segments < 2)
+    return order;
+
+  // Breadth first over the intervals, so that each level halves the largest gap between checked states
+  std::deque<std::pair<std::size_t, std::size_t>> intervals{ { 0, n_segments } };
+  while (!intervals.empty())
+  {
+    const std::size_t lo = intervals.front().first;
+    const std::size_t hi = intervals.front().second;
+    intervals.pop_front();
+    if (hi - lo < 2)
+      continue;
+
+    const std::size_t mid = lo + (hi - lo) / 2;
+    order.push_back(mid);
+    intervals.emplace_back(lo, mid);
+    intervals.emplace_back(mid, hi);
+  }
+
+  return order;
+}
+
+}  // namespace descartes_light
+
+#endif  // DESCARTES_SAMPLERS_EVALUATORS_COLLISION_EDGE_EVALUATOR_HPP
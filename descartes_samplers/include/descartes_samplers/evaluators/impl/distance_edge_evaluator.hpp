@@ -19,37 +19,16 @@
 #define DESCARTES_SAMPLERS_EVALUATORS_IMPL_DISTANCE_EDGE_EVALUATOR_HPP
 
 #include "descartes_samplers/evaluators/distance_edge_evaluator.h"
-#include <cmath>
-
-namespace
-{
-template <typename FloatType>
-static void considerEdge(const FloatType* start,
-                         const FloatType* end,
-                         const std::vector<FloatType>& delta_thresholds,
-                         std::size_t next_idx,
-                         typename descartes_light::LadderGraph<FloatType>::EdgeList& out)
-{
-  FloatType cost = static_cast<FloatType>(0.0);
-  for (std::size_t i = 0; i < delta_thresholds.size(); ++i)
-  {
-    FloatType step = end[i] - start[i];
-    if (std::abs(step) > delta_thresholds[i])
-      return;
-
-    cost += std::pow(step, FloatType(2));
-  }
-
-  out.emplace_back(cost, next_idx);
-}
-
-}  // namespace
+#include "descartes_samplers/evaluators/impl/joint_distance_kernel.hpp"
+#include <algorithm>
+#include <limits>
 
 namespace descartes_light
 {
 template <typename FloatType>
-DistanceEdgeEvaluator<FloatType>::DistanceEdgeEvaluator(const std::vector<FloatType>& velocity_limits)
-  : velocity_limits_(velocity_limits)
+DistanceEdgeEvaluator<FloatType>::DistanceEdgeEvaluator(const std::vector<FloatType>& velocity_limits,
+                                                        const bool use_matrix_product)
+  : velocity_limits_(velocity_limits), use_matrix_product_(use_matrix_product)
 {
 }
 
@@ -59,8 +38,6 @@ bool DistanceEdgeEvaluator<FloatType>::evaluate(const Rung_<FloatType>& from,
                                                 std::vector<typename LadderGraph<FloatType>::EdgeList>& edges)
 {
   const auto dof = velocity_limits_.size();
-  const auto n_start = from.data.size() / dof;
-  const auto n_end = to.data.size() / dof;
 
   // Compute thresholds
   const auto dt = to.timing;
@@ -81,26 +58,10 @@ bool DistanceEdgeEvaluator<FloatType>::evaluate(const Rung_<FloatType>& from,
                    }
                  });
 
-  // Allocate
-  edges.resize(n_start);
-
-  for (std::size_t i = 0; i < n_start; ++i)
-  {
-    const auto* start_vertex = from.data.data() + dof * i;
-    for (std::size_t j = 0; j < n_end; ++j)
-    {
-      const auto* end_vertex = to.data.data() + dof * j;
-
-      // Consider the edge:
-      considerEdge(start_vertex, end_vertex, delta_thresholds, j, edges[i]);
-    }
-  }
-
-  for (const auto& rung : edges)
-    if (!rung.empty())
-      return true;
+  if (use_matrix_product_)
+    return jointDistanceEdgesProduct<FloatType, true>(from, to, dof, 0, delta_thresholds.data(), edges);
 
-  return false;
+  return jointDistanceEdgesSweep<FloatType>(from, to, dof, 0, delta_thresholds.data(), edges);
 }
 
 }  // namespace descartes_light
@@ -19,32 +19,13 @@
 #define DESCARTES_SAMPLERS_EVALUATORS_EUCLIDEAN_DISTANCE_EDGE_EVALUATOR_HPP
 
 #include <descartes_samplers/evaluators/euclidean_distance_edge_evaluator.h>
-#include <cmath>
-
-namespace
-{
-template <typename FloatType>
-static void considerEdge(const FloatType* start,
-                         const FloatType* end,
-                         std::size_t dof,
-                         std::size_t next_idx,
-                         typename descartes_light::LadderGraph<FloatType>::EdgeList& out)
-{
-  FloatType cost = 0.0;
-  for (std::size_t i = 0; i < dof; ++i)
-  {
-    cost += std::pow(end[i] - start[i], FloatType(2));
-  }
-
-  out.emplace_back(cost, next_idx);
-}
-
-}  // namespace
+#include <descartes_samplers/evaluators/impl/joint_distance_kernel.hpp>
 
 namespace descartes_light
 {
 template <typename FloatType>
-EuclideanDistanceEdgeEvaluator<FloatType>::EuclideanDistanceEdgeEvaluator(int dof) : dof_(static_cast<std::size_t>(dof))
+EuclideanDistanceEdgeEvaluator<FloatType>::EuclideanDistanceEdgeEvaluator(int dof, const bool use_matrix_product)
+  : dof_(static_cast<std::size_t>(dof)), use_matrix_product_(use_matrix_product)
 {
 }
 
@@ -53,29 +34,10 @@ bool EuclideanDistanceEdgeEvaluator<FloatType>::evaluate(const Rung_<FloatType>&
                                                          const Rung_<FloatType>& to,
                                                          std::vector<typename LadderGraph<FloatType>::EdgeList>& edges)
 {
-  const auto n_start = from.data.size() / dof_;
-  const auto n_end = to.data.size() / dof_;
-
-  // Allocate
-  edges.resize(n_start);
-
-  for (std::size_t i = 0; i < n_start; ++i)
-  {
-    const auto* start_vertex = from.data.data() + dof_ * i;
-    for (std::size_t j = 0; j < n_end; ++j)
-    {
-      const auto* end_vertex = to.data.data() + dof_ * j;
-
-      // Consider the edge:
-      considerEdge(start_vertex, end_vertex, dof_, j, edges[i]);
-    }
-  }
-
-  for (const auto& rung : edges)
-    if (!rung.empty())
-      return true;
+  if (use_matrix_product_)
+    return jointDistanceEdgesProduct<FloatType, false>(from, to, dof_, 0, nullptr, edges);
 
-  return false;
+  return jointDistanceEdges<FloatType, false>(from, to, dof_, 0, nullptr, edges);
 }
 
 }  // namespace descartes_light
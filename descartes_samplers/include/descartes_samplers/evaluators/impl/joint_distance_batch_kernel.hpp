@@ -0,0 +1,112 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2016, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef DESCARTES_SAMPLERS_EVALUATORS_IMPL_JOINT_DISTANCE_BATCH_KERNEL_HPP
+#define DESCARTES_SAMPLERS_EVALUATORS_IMPL_JOINT_DISTANCE_BATCH_KERNEL_HPP
+
+// The lane loops below are compiled once per instruction set, each time in a namespace named by
+// DESCARTES_JOINT_DISTANCE_ISA. No library functions are called from it, so code built for a wider instruction set can
+// never be picked up by the linker in place of the baseline code.
+#ifndef DESCARTES_JOINT_DISTANCE_ISA
+#error "DESCARTES_JOINT_DISTANCE_ISA must name the instruction set this kernel is compiled for"
+#endif
+
+#include <descartes_samplers/evaluators/joint_distance_batch.h>
+
+#if defined(__GNUC__)
+#define DESCARTES_JOINT_DISTANCE_SIMD _Pragma("omp simd")
+#else
+#define DESCARTES_JOINT_DISTANCE_SIMD
+#endif
+
+namespace descartes_light
+{
+namespace joint_distance
+{
+namespace DESCARTES_JOINT_DISTANCE_ISA
+{
+/** @brief The number of end vertices processed per pass over the joints, sized to keep the pass in L1 */
+static const std::size_t BLOCK_SIZE = 256;
+
+template <typename FloatType>
+void costs(const FloatType* start,
+           const FloatType* ends,
+           const std::size_t stride,
+           const std::size_t n_end,
+           const std::size_t dof,
+           const std::size_t first_joint,
+           const FloatType* delta_thresholds,
+           FloatType* costs)
+{
+  alignas(64) FloatType excess[BLOCK_SIZE];
+
+  for (std::size_t begin = 0; begin < n_end; begin += BLOCK_SIZE)
+  {
+    const std::size_t n = n_end - begin < BLOCK_SIZE ? n_end - begin : BLOCK_SIZE;
+    FloatType* cost = costs + begin;
+
+    DESCARTES_JOINT_DISTANCE_SIMD
+    for (std::size_t j = 0; j < n; ++j)
+    {
+      cost[j] = FloatType(0);
+      excess[j] = FloatType(-1);
+    }
+
+    // Joint by joint, so that each lane sums its cost in the same order as the scalar loop
+    for (std::size_t k = first_joint; k < dof; ++k)
+    {
+      const FloatType s = start[k];
+      const FloatType* e = ends + k * stride + begin;
+      if (delta_thresholds != nullptr)
+      {
+        const FloatType limit = delta_thresholds[k];
+        DESCARTES_JOINT_DISTANCE_SIMD
+        for (std::size_t j = 0; j < n; ++j)
+        {
+          const FloatType step = e[j] - s;
+          cost[j] += step * step;
+
+          // |step| - limit is positive exactly when |step| > limit
+          const FloatType over = (step < FloatType(0) ? -step : step) - limit;
+          excess[j] = over > excess[j] ? over : excess[j];
+        }
+      }
+      else
+      {
+        DESCARTES_JOINT_DISTANCE_SIMD
+        for (std::size_t j = 0; j < n; ++j)
+        {
+          const FloatType step = e[j] - s;
+          cost[j] += step * step;
+        }
+      }
+    }
+
+    if (delta_thresholds != nullptr)
+    {
+      DESCARTES_JOINT_DISTANCE_SIMD
+      for (std::size_t j = 0; j < n; ++j)
+        cost[j] = excess[j] > FloatType(0) ? FloatType(-1) : cost[j];
+    }
+  }
+}
+
+}  // namespace DESCARTES_JOINT_DISTANCE_ISA
+}  // namespace joint_distance
+}  // namespace descartes_light
+
+#endif  // DESCARTES_SAMPLERS_EVALUATORS_IMPL_JOINT_DISTANCE_BATCH_KERNEL_HPP
@@ -0,0 +1,378 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2016, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef DESCARTES_SAMPLERS_EVALUATORS_IMPL_JOINT_DISTANCE_KERNEL_HPP
+#define DESCARTES_SAMPLERS_EVALUATORS_IMPL_JOINT_DISTANCE_KERNEL_HPP
+
+#include <descartes_light/ladder_graph.h>
+#include <descartes_samplers/evaluators/joint_distance_batch.h>
+#include <Eigen/Core>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace descartes_light
+{
+/** @brief The DOF argument of the joint distance kernels when the number of joints is only known at runtime */
+constexpr std::size_t DYNAMIC_DOF = 0;
+
+/**
+ * @brief Computes the edges between two rungs, costed by the squared joint distance of joints [first_joint, dof)
+ *
+ * With a compile time DOF the joint loops are fully unrolled and the vertex strides are constants; with DYNAMIC_DOF
+ * the runtime 'dof' is used instead.
+ *
+ * @param delta_thresholds If Limited, the largest joint steps of an edge; edges exceeding one are left out
+ * @return True if at least one edge was found
+ */
+template <typename FloatType, std::size_t DOF, bool Limited>
+inline bool jointDistanceEdges(const Rung_<FloatType>& from,
+                               const Rung_<FloatType>& to,
+                               const std::size_t dof,
+                               const std::size_t first_joint,
+                               const FloatType* delta_thresholds,
+                               std::vector<typename LadderGraph<FloatType>::EdgeList>& edges)
+{
+  const std::size_t n_joints = DOF == DYNAMIC_DOF ? dof : DOF;
+  const std::size_t n_start = from.data.size() / n_joints;
+  const std::size_t n_end = to.data.size() / n_joints;
+
+  // Allocate
+  edges.resize(n_start);
+
+  bool found = false;
+  for (std::size_t i = 0; i < n_start; ++i)
+  {
+    const FloatType* start_vertex = from.data.data() + n_joints * i;
+    auto& out = edges[i];
+    for (std::size_t j = 0; j < n_end; ++j)
+    {
+      const FloatType* end_vertex = to.data.data() + n_joints * j;
+
+      // No early exit, so the joint loop stays branch free
+      FloatType cost = static_cast<FloatType>(0.0);
+      bool feasible = true;
+      for (std::size_t k = first_joint; k < n_joints; ++k)
+      {
+        const FloatType step = end_vertex[k] - start_vertex[k];
+        if (Limited)
+          feasible &= !(std::abs(step) > delta_thresholds[k]);
+        cost += step * step;
+      }
+
+      if (feasible)
+        out.emplace_back(cost, static_cast<unsigned>(j));
+    }
+    found = found || !out.empty();
+  }
+
+  return found;
+}
+
+/**
+ * @brief jointDistanceEdges() on top of the vectorized jointDistanceCosts()
+ *
+ * The end rung is transposed to one array per joint once, then the costs from each start vertex to all end vertices
+ * are computed in SIMD lanes. The costs are bit identical to the scalar kernel.
+ */
+template <typename FloatType, bool Limited>
+inline bool jointDistanceEdgesBatched(const Rung_<FloatType>& from,
+                                      const Rung_<FloatType>& to,
+                                      const std::size_t dof,
+                                      const std::size_t first_joint,
+                                      const FloatType* delta_thresholds,
+                                      std::vector<typename LadderGraph<FloatType>::EdgeList>& edges)
+{
+  const std::size_t n_start = from.data.size() / dof;
+  const std::size_t n_end = to.data.size() / dof;
+
+  thread_local std::vector<FloatType> ends;
+  thread_local std::vector<FloatType> costs;
+  ends.resize(dof * n_end);
+  costs.resize(n_end);
+  for (std::size_t j = 0; j < n_end; ++j)
+    for (std::size_t k = 0; k < dof; ++k)
+      ends[k * n_end + j] = to.data[j * dof + k];
+
+  // Allocate
+  edges.resize(n_start);
+
+  bool found = false;
+  for (std::size_t i = 0; i < n_start; ++i)
+  {
+    jointDistanceCosts(from.data.data() + dof * i,
+                       ends.data(),
+                       n_end,
+                       n_end,
+                       dof,
+                       first_joint,
+                       Limited ? delta_thresholds : nullptr,
+                       costs.data());
+
+    auto& out = edges[i];
+    for (std::size_t j = 0; j < n_end; ++j)
+      if (!(costs[j] < static_cast<FloatType>(0.0)))
+        out.emplace_back(costs[j], static_cast<unsigned>(j));
+
+    found = found || !out.empty();
+  }
+
+  return found;
+}
+
+/**
+ * @brief jointDistanceEdges() through matrix products, for large rungs
+ *
+ * With the vertices of a rung as the columns of A and B, the squared distances of all vertex pairs are
+ * |a|^2 + |b|^2 - 2 B^T A, so the whole block of costs comes from one blocked matrix product instead of a loop per
+ * pair. The costs differ from the direct sums by rounding (the subtraction cancels for nearby vertices, negative
+ * results are clamped to zero).
+ *
+ * The thresholds are fused in the same way: the squared distance S in joints scaled by 1 / delta_threshold bounds the
+ * largest scaled step m by m^2 <= S <= n_joints * m^2. Pairs with S clearly below 1 are within every threshold and
+ * pairs with S clearly above n_joints are not; only the pairs in between are checked joint by joint.
+ */
+template <typename FloatType, bool Limited>
+inline bool jointDistanceEdgesProduct(const Rung_<FloatType>& from,
+                                      const Rung_<FloatType>& to,
+                                      const std::size_t dof,
+                                      const std::size_t first_joint,
+                                      const FloatType* delta_thresholds,
+                                      std::vector<typename LadderGraph<FloatType>::EdgeList>& edges)
+{
+  using Matrix = Eigen::Matrix<FloatType, Eigen::Dynamic, Eigen::Dynamic>;
+  using Vector = Eigen::Matrix<FloatType, Eigen::Dynamic, 1>;
+
+  const std::size_t n_start = from.data.size() / dof;
+  const std::size_t n_end = to.data.size() / dof;
+  const auto n_joints = static_cast<Eigen::Index>(dof - first_joint);
+
+  // Each vertex is a column; the joints before 'first_joint' do not count
+  const auto rows = static_cast<Eigen::Index>(dof);
+  const auto a_cols = static_cast<Eigen::Index>(n_start);
+  const auto b_cols = static_cast<Eigen::Index>(n_end);
+  const auto a = Eigen::Map<const Matrix>(from.data.data(), rows, a_cols).bottomRows(n_joints);
+  const auto b = Eigen::Map<const Matrix>(to.data.data(), rows, b_cols).bottomRows(n_joints);
+
+  thread_local Matrix products, scaled_products, a_scaled, b_scaled;
+  thread_local Vector a_norms, b_norms, a_scaled_norms, b_scaled_norms, inverse_thresholds;
+
+  // Column i holds the products of start vertex i with every end vertex
+  products.noalias() = b.transpose() * a;
+  a_norms = a.colwise().squaredNorm().transpose();
+  b_norms = b.colwise().squaredNorm().transpose();
+
+  if (Limited)
+  {
+    inverse_thresholds = Eigen::Map<const Vector>(delta_thresholds + first_joint, n_joints).cwiseInverse();
+    a_scaled.noalias() = inverse_thresholds.asDiagonal() * a;
+    b_scaled.noalias() = inverse_thresholds.asDiagonal() * b;
+    scaled_products.noalias() = b_scaled.transpose() * a_scaled;
+    a_scaled_norms = a_scaled.colwise().squaredNorm().transpose();
+    b_scaled_norms = b_scaled.colwise().squaredNorm().transpose();
+  }
+
+  // The rounding error of |a|^2 + |b|^2 - 2 a.b is within a few epsilon of |a|^2 + |b|^2
+  const FloatType tolerance = static_cast<FloatType>(4 * (n_joints + 2)) * std::numeric_limits<FloatType>::epsilon();
+  const FloatType bound = static_cast<FloatType>(n_joints);
+
+  // Allocate
+  edges.resize(n_start);
+
+  bool found = false;
+  for (std::size_t i = 0; i < n_start; ++i)
+  {
+    const auto ci = static_cast<Eigen::Index>(i);
+    const FloatType* start_vertex = from.data.data() + dof * i;
+    auto& out = edges[i];
+    for (std::size_t j = 0; j < n_end; ++j)
+    {
+      const auto cj = static_cast<Eigen::Index>(j);
+      if (Limited)
+      {
+        const FloatType magnitude = a_scaled_norms(ci) + b_scaled_norms(cj);
+        const FloatType scaled = magnitude - 2 * scaled_products(cj, ci);
+        const FloatType error = tolerance * magnitude;
+        if (scaled - error > bound)
+          continue;
+
+        // Also taken for NaN, e.g. from a zero threshold
+        if (!(scaled + error <= static_cast<FloatType>(1.0)))
+        {
+          const FloatType* end_vertex = to.data.data() + dof * j;
+          bool feasible = true;
+          for (std::size_t k = first_joint; k < dof && feasible; ++k)
+            feasible = !(std::abs(end_vertex[k] - start_vertex[k]) > delta_thresholds[k]);
+
+          if (!feasible)
+            continue;
+        }
+      }
+
+      const FloatType cost = a_norms(ci) + b_norms(cj) - 2 * products(cj, ci);
+      out.emplace_back(std::max(cost, static_cast<FloatType>(0.0)), static_cast<unsigned>(j));
+    }
+    found = found || !out.empty();
+  }
+
+  return found;
+}
+
+/**
+ * @brief Dispatches jointDistanceEdges() to the vectorized kernel, or on CPUs without AVX2 to the kernels specialized
+ * for 6, 7 and 8 joints or the dynamic one
+ */
+template <typename FloatType, bool Limited>
+inline bool jointDistanceEdges(const Rung_<FloatType>& from,
+                               const Rung_<FloatType>& to,
+                               const std::size_t dof,
+                               const std::size_t first_joint,
+                               const FloatType* delta_thresholds,
+                               std::vector<typename LadderGraph<FloatType>::EdgeList>& edges)
+{
+  static const bool vectorized = std::strcmp(jointDistanceInstructionSet(), "sse2") != 0;
+  if (vectorized)
+    return jointDistanceEdgesBatched<FloatType, Limited>(from, to, dof, first_joint, delta_thresholds, edges);
+
+  switch (dof)
+  {
+    case 6:
+      return jointDistanceEdges<FloatType, 6, Limited>(from, to, dof, first_joint, delta_thresholds, edges);
+    case 7:
+      return jointDistanceEdges<FloatType, 7, Limited>(from, to, dof, first_joint, delta_thresholds, edges);
+    case 8:
+      return jointDistanceEdges<FloatType, 8, Limited>(from, to, dof, first_joint, delta_thresholds, edges);
+    default:
+      return jointDistanceEdges<FloatType, DYNAMIC_DOF, Limited>(from, to, dof, first_joint, delta_thresholds, edges);
+  }
+}
+
+/**
+ * @brief The velocity limited jointDistanceEdges() through a sorted sweep over the end rung
+ *
+ * The end vertices are sorted by the joint whose threshold rejects the largest share of them, so the candidates of a
+ * start vertex are the range of that joint within its threshold, found by binary search. Only the candidates are
+ * checked on every joint, which makes the evaluation close to linear in the rung sizes when the thresholds are tight.
+ * The edges and their costs are the same as those of jointDistanceEdges(), in the same order.
+ *
+ * When no joint is selective enough for the sweep to pay off (e.g. without a time step, where every threshold is the
+ * largest FloatType), this falls back to jointDistanceEdges().
+ */
+template <typename FloatType>
+inline bool jointDistanceEdgesSweep(const Rung_<FloatType>& from,
+                                    const Rung_<FloatType>& to,
+                                    const std::size_t dof,
+                                    const std::size_t first_joint,
+                                    const FloatType* delta_thresholds,
+                                    std::vector<typename LadderGraph<FloatType>::EdgeList>& edges)
+{
+  // Below these, sorting costs more than the pairs it saves (e.g. for the single vertices evaluated by lazy searches)
+  const std::size_t min_vertices = 32;
+  const double max_candidate_fraction = 0.25;
+
+  const std::size_t n_start = from.data.size() / dof;
+  const std::size_t n_end = to.data.size() / dof;
+  if (n_start < min_vertices || n_end < min_vertices)
+    return jointDistanceEdges<FloatType, true>(from, to, dof, first_joint, delta_thresholds, edges);
+
+  // For evenly spread vertices, a threshold t on a joint spanning r keeps about 2t / r of them
+  std::size_t sweep_joint = dof;
+  double candidate_fraction = max_candidate_fraction;
+  for (std::size_t k = first_joint; k < dof; ++k)
+  {
+    FloatType lowest = to.data[k];
+    FloatType highest = to.data[k];
+    for (std::size_t j = 1; j < n_end; ++j)
+    {
+      lowest = std::min(lowest, to.data[dof * j + k]);
+      highest = std::max(highest, to.data[dof * j + k]);
+    }
+
+    const double range = static_cast<double>(highest) - static_cast<double>(lowest);
+    const double fraction = 2.0 * static_cast<double>(delta_thresholds[k]) / range;
+    if (range > 0.0 && fraction < candidate_fraction)
+    {
+      sweep_joint = k;
+      candidate_fraction = fraction;
+    }
+  }
+
+  if (sweep_joint == dof)
+    return jointDistanceEdges<FloatType, true>(from, to, dof, first_joint, delta_thresholds, edges);
+
+  thread_local std::vector<unsigned> order;
+  thread_local std::vector<FloatType> keys;
+  order.resize(n_end);
+  keys.resize(n_end);
+  for (std::size_t j = 0; j < n_end; ++j)
+    order[j] = static_cast<unsigned>(j);
+  std::sort(order.begin(), order.end(), [&to, dof, sweep_joint](unsigned lhs, unsigned rhs) {
+    return to.data[dof * lhs + sweep_joint] < to.data[dof * rhs + sweep_joint];
+  });
+  for (std::size_t j = 0; j < n_end; ++j)
+    keys[j] = to.data[dof * order[j] + sweep_joint];
+
+  const FloatType threshold = delta_thresholds[sweep_joint];
+
+  // Allocate
+  edges.resize(n_start);
+
+  bool found = false;
+  for (std::size_t i = 0; i < n_start; ++i)
+  {
+    const FloatType* start_vertex = from.data.data() + dof * i;
+    const FloatType center = start_vertex[sweep_joint];
+
+    // Widened by the rounding of center +- threshold; the exact check below has the final say
+    const FloatType slack = 4 * std::numeric_limits<FloatType>::epsilon() * (std::abs(center) + threshold);
+    const auto lower = std::lower_bound(keys.begin(), keys.end(), center - threshold - slack);
+    const auto upper = std::upper_bound(lower, keys.end(), center + threshold + slack);
+
+    auto& out = edges[i];
+    const auto first_edge = static_cast<std::ptrdiff_t>(out.size());
+    for (auto it = lower; it != upper; ++it)
+    {
+      const unsigned j = order[static_cast<std::size_t>(it - keys.begin())];
+      const FloatType* end_vertex = to.data.data() + dof * j;
+
+      FloatType cost = static_cast<FloatType>(0.0);
+      bool feasible = true;
+      for (std::size_t k = first_joint; k < dof; ++k)
+      {
+        const FloatType step = end_vertex[k] - start_vertex[k];
+        feasible &= !(std::abs(step) > delta_thresholds[k]);
+        cost += step * step;
+      }
+
+      if (feasible)
+        out.emplace_back(cost, j);
+    }
+
+    // Back to the order of the end rung, as produced by the exhaustive kernels
+    std::sort(out.begin() + first_edge, out.end(), [](const Edge_<FloatType>& lhs, const Edge_<FloatType>& rhs) {
+      return lhs.idx < rhs.idx;
+    });
+    found = found || !out.empty();
+  }
+
+  return found;
+}
+
+}  // namespace descartes_light
+
+#endif  // DESCARTES_SAMPLERS_EVALUATORS_IMPL_JOINT_DISTANCE_KERNEL_HPP
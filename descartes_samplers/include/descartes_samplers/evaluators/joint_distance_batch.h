@@ -0,0 +1,59 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2016, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef DESCARTES_SAMPLERS_EVALUATORS_JOINT_DISTANCE_BATCH_H
+#define DESCARTES_SAMPLERS_EVALUATORS_JOINT_DISTANCE_BATCH_H
+
+#include <descartes_light/visibility_control.h>
+#include <cstddef>
+
+// This header is included by translation units built for AVX2/AVX-512 while the rest of the library is built with
+// -mno-avx, so it must not include Eigen, the ladder graph or anything else that defines inline code shared with the
+// rest of the library.
+
+namespace descartes_light
+{
+/**
+ * @brief Computes the squared joint distance from one vertex to each of 'n_end' vertices
+ *
+ * The costs are summed over joints [first_joint, dof) in joint order, so they are bit identical to a scalar loop. The
+ * vertices are processed in SIMD lanes; the widest instruction set supported by the CPU (SSE2, AVX2 or AVX-512) is
+ * selected the first time this is called.
+ *
+ * @param start The start vertex, 'dof' joint values
+ * @param ends The end vertices stored joint by joint: joint k of vertex j is ends[k * stride + j]
+ * @param stride The distance between the joints of the end vertices, at least 'n_end'
+ * @param n_end The number of end vertices
+ * @param delta_thresholds The largest joint steps of an edge, 'dof' values, or nullptr for no limit
+ * @param costs The 'n_end' costs. The cost of an edge exceeding a threshold is negative.
+ */
+template <typename FloatType>
+DESCARTES_PUBLIC void jointDistanceCosts(const FloatType* start,
+                                         const FloatType* ends,
+                                         std::size_t stride,
+                                         std::size_t n_end,
+                                         std::size_t dof,
+                                         std::size_t first_joint,
+                                         const FloatType* delta_thresholds,
+                                         FloatType* costs);
+
+/** @brief The instruction set used by jointDistanceCosts() on this CPU: "avx512", "avx2" or "sse2" */
+DESCARTES_PUBLIC const char* jointDistanceInstructionSet();
+
+}  // namespace descartes_light
+
+#endif  // DESCARTES_SAMPLERS_EVALUATORS_JOINT_DISTANCE_BATCH_H
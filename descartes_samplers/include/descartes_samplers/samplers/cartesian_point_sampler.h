@@ -22,6 +22,7 @@
 #include <descartes_light/interface/kinematics_interface.h>
 #include <descartes_light/interface/collision_interface.h>
 #include <descartes_light/interface/position_sampler.h>
+#include <descartes_light/thread_clones.h>
 #include <descartes_light/utils.h>
 
 namespace descartes_light
@@ -37,9 +38,17 @@ public:
 
   bool sample(std::vector<FloatType>& solution_set) override;
 
+  /** @brief Appends every IK solution unchecked; with allow_collision, samples and checks them like sample() */
+  bool sampleUnchecked(std::vector<FloatType>& solution_set) override;
+
+  bool isValid(const FloatType* vertex) override;
+
 private:
+  /** @brief The number of joints of a solution of the OPW robot */
+  static constexpr std::size_t opw_dof = 6;
+
+  /** @brief Checks a single solution for collision, see sample() for the batched check */
   bool isCollisionFree(const FloatType* vertex);
-  bool getBestSolution(std::vector<FloatType>& solution_set);
 
   Eigen::Transform<FloatType, 3, Eigen::Isometry> tool_pose_;
   typename KinematicsInterface<FloatType>::Ptr kin_;
@@ -22,6 +22,7 @@
 #include <descartes_light/interface/kinematics_interface.h>
 #include <descartes_light/interface/collision_interface.h>
 #include <descartes_light/interface/position_sampler.h>
+#include <descartes_light/thread_clones.h>
 
 namespace descartes_light
 {
@@ -35,9 +36,16 @@ public:
 
   bool sample(std::vector<FloatType>& solution_set) override;
 
+  bool sampleUnchecked(std::vector<FloatType>& solution_set) override;
+
+  bool isValid(const FloatType* vertex) override;
+
 private:
   bool isCollisionFree(const FloatType* vertex);
 
+  /** @brief Appends the solutions over the positioner angles, only those free of collision if 'check' is set */
+  bool sampleSolutions(std::vector<FloatType>& solution_set, const bool check);
+
   Eigen::Transform<FloatType, 3, Eigen::Isometry> tool_pose_;
   typename KinematicsInterface<FloatType>::Ptr kin_;
   typename CollisionInterface<FloatType>::Ptr collision_;
@@ -56,9 +64,16 @@ public:
 
   bool sample(std::vector<FloatType>& solution_set) override;
 
+  bool sampleUnchecked(std::vector<FloatType>& solution_set) override;
+
+  bool isValid(const FloatType* vertex) override;
+
 private:
   bool isCollisionFree(const FloatType* vertex);
 
+  /** @brief Appends the solutions over the positioner angles, only those free of collision if 'check' is set */
+  bool sampleSolutions(std::vector<FloatType>& solution_set, const bool check);
+
   Eigen::Transform<FloatType, 3, Eigen::Isometry> tool_pose_;
   typename KinematicsInterface<FloatType>::Ptr kin_;
   typename CollisionInterface<FloatType>::Ptr collision_;
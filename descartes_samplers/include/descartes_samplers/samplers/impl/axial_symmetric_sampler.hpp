@@ -20,8 +20,6 @@
 
 #include "descartes_samplers/samplers/axial_symmetric_sampler.h"
 
-const static std::size_t opw_dof = 6;
-
 namespace descartes_light
 {
 template <typename FloatType>
@@ -42,79 +40,61 @@ AxialSymmetricSampler<FloatType>::AxialSymmetricSampler(
 template <typename FloatType>
 bool AxialSymmetricSampler<FloatType>::sample(std::vector<FloatType>& solution_set)
 {
-  std::vector<FloatType> buffer;
-
-  const auto nSamplesInBuffer = [](const std::vector<FloatType>& v) -> std::size_t { return v.size() / opw_dof; };
-
-  FloatType angle = static_cast<FloatType>(-1.0 * M_PI);
-
-  while (angle <= static_cast<FloatType>(M_PI))  // loop over each waypoint
-  {
-    Eigen::Transform<FloatType, 3, Eigen::Isometry> p =
-        tool_pose_ * Eigen::AngleAxis<FloatType>(angle, Eigen::Matrix<FloatType, 3, 1>::UnitZ());
-    kin_->ik(p, buffer);
-
-    const auto n_sols = nSamplesInBuffer(buffer);
-    for (std::size_t i = 0; i < n_sols; ++i)
-    {
-      const auto* sol_data = buffer.data() + i * opw_dof;
-      if (isCollisionFree(sol_data))
-        solution_set.insert(end(solution_set), sol_data, sol_data + opw_dof);
-    }
-    buffer.clear();
-
-    angle += radial_sample_res_;
-  }  // redundancy resolution loop
-
-  if (solution_set.empty() && allow_collision_)
-    getBestSolution(solution_set);
+  thread_local typename KinematicsInterface<FloatType>::PoseVector poses;
+  thread_local std::vector<FloatType> buffer;
+  thread_local std::vector<std::size_t> offsets;
+  samplePoses(poses);
+  buffer.clear();
+  ThreadClones::local(kin_)->ik(poses.data(), poses.size(), buffer, offsets);
+
+  // Check every solution in one batch, falling back to the least colliding one if collisions are allowed
+  appendCollisionFree(ThreadClones::local(collision_),
+                      buffer.data(),
+                      opw_dof,
+                      buffer.size() / opw_dof,
+                      allow_collision_,
+                      solution_set);
+  return !solution_set.empty();
+}
 
+template <typename FloatType>
+bool AxialSymmetricSampler<FloatType>::sampleUnchecked(std::vector<FloatType>& solution_set)
+{
+  // Falling back to the least colliding solution needs every solution checked
+  if (allow_collision_ || collision_ == nullptr)
+    return sample(solution_set);
+
+  thread_local typename KinematicsInterface<FloatType>::PoseVector poses;
+  thread_local std::vector<std::size_t> offsets;
+  samplePoses(poses);
+  ThreadClones::local(kin_)->ik(poses.data(), poses.size(), solution_set, offsets);
   return !solution_set.empty();
 }
 
 template <typename FloatType>
-bool AxialSymmetricSampler<FloatType>::isCollisionFree(const FloatType* vertex)
+bool AxialSymmetricSampler<FloatType>::isValid(const FloatType* vertex)
 {
-  if (collision_ == nullptr)
-    return true;
-  else
-    return collision_->validate(vertex, opw_dof);
+  return allow_collision_ || isCollisionFree(vertex);
 }
 
 template <typename FloatType>
-bool AxialSymmetricSampler<FloatType>::getBestSolution(std::vector<FloatType>& solution_set)
+bool AxialSymmetricSampler<FloatType>::isCollisionFree(const FloatType* vertex)
 {
-  FloatType distance = -std::numeric_limits<FloatType>::max();
-  std::vector<FloatType> buffer;
+  return collision_ == nullptr || ThreadClones::local(collision_)->validate(vertex, opw_dof);
+}
 
-  const auto nSamplesInBuffer = [](const std::vector<FloatType>& v) -> std::size_t { return v.size() / opw_dof; };
+template <typename FloatType>
+void AxialSymmetricSampler<FloatType>::samplePoses(typename KinematicsInterface<FloatType>::PoseVector& poses) const
+{
+  poses.clear();
+  poses.reserve(static_cast<std::size_t>(2.0 * M_PI / static_cast<double>(radial_sample_res_)) + 1);
 
   FloatType angle = static_cast<FloatType>(-1.0 * M_PI);
-
-  while (angle <= M_PI)  // loop over each waypoint
+  while (angle <= static_cast<FloatType>(M_PI))  // loop over each waypoint
   {
-    Eigen::Transform<FloatType, 3, Eigen::Isometry> p =
-        tool_pose_ * Eigen::AngleAxis<FloatType>(angle, Eigen::Matrix<FloatType, 3, 1>::UnitZ());
-    kin_->ik(p, buffer);
-
-    const auto n_sols = nSamplesInBuffer(buffer);
-    for (std::size_t i = 0; i < n_sols; ++i)
-    {
-      const auto* sol_data = buffer.data() + i * opw_dof;
-      FloatType cur_distance = collision_->distance(sol_data, opw_dof);
-      if (cur_distance > distance)
-      {
-        distance = cur_distance;
-        solution_set.clear();
-        solution_set.insert(end(solution_set), sol_data, sol_data + opw_dof);
-      }
-    }
-    buffer.clear();
-
+    poses.push_back(tool_pose_ * Eigen::AngleAxis<FloatType>(angle, Eigen::Matrix<FloatType, 3, 1>::UnitZ()));
     angle += radial_sample_res_;
   }  // redundancy resolution loop
-
-  return !solution_set.empty();
 }
 
 }  // namespace descartes_light
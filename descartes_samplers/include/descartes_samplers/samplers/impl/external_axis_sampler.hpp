@@ -34,11 +34,29 @@ ExternalAxisSampler<FloatType>::ExternalAxisSampler(
 template <typename FloatType>
 bool ExternalAxisSampler<FloatType>::isCollisionFree(const FloatType* vertex)
 {
-  return collision_->validate(vertex, 7);
+  return ThreadClones::local(collision_)->validate(vertex, 7);
 }
 
 template <typename FloatType>
 bool ExternalAxisSampler<FloatType>::sample(std::vector<FloatType>& solution_set)
+{
+  return sampleSolutions(solution_set, true);
+}
+
+template <typename FloatType>
+bool ExternalAxisSampler<FloatType>::sampleUnchecked(std::vector<FloatType>& solution_set)
+{
+  return sampleSolutions(solution_set, false);
+}
+
+template <typename FloatType>
+bool ExternalAxisSampler<FloatType>::isValid(const FloatType* vertex)
+{
+  return isCollisionFree(vertex);
+}
+
+template <typename FloatType>
+bool ExternalAxisSampler<FloatType>::sampleSolutions(std::vector<FloatType>& solution_set, const bool check)
 {
   // We need to translate the tool pose to the "robot" frame
   // We need some strategy for moving the positioner around to generate many of these frames
@@ -56,25 +74,40 @@ bool ExternalAxisSampler<FloatType>::sample(std::vector<FloatType>& solution_set
 
   // So we just loop
   const static FloatType discretization = static_cast<FloatType>(M_PI / 36.0);
+  thread_local std::vector<FloatType> angles;
+  thread_local typename KinematicsInterface<FloatType>::PoseVector poses;
+  angles.clear();
+  poses.clear();
   for (FloatType angle = static_cast<FloatType>(-1.0 * M_PI); angle <= static_cast<FloatType>(M_PI);
        angle += discretization)
   {
-    std::vector<FloatType> buffer;
-    kin_->ik(to_robot_frame(tool_pose_, angle), buffer);
+    angles.push_back(angle);
+    poses.push_back(to_robot_frame(tool_pose_, angle));
+  }
+
+  // Solve every positioner angle in one call
+  thread_local std::vector<FloatType> buffer;
+  thread_local std::vector<std::size_t> offsets;
+  buffer.clear();
+  ThreadClones::local(kin_)->ik(poses.data(), poses.size(), buffer, offsets);
 
-    // Now test the solutions
-    const auto n_sols = buffer.size() / 6;
-    for (std::size_t i = 0; i < n_sols; ++i)
+  // Append the positioner angle to each solution, then test them all in one batch
+  thread_local std::vector<FloatType> vertices;
+  vertices.clear();
+  for (std::size_t a = 0; a < angles.size(); ++a)
+  {
+    for (std::size_t i = offsets[a]; i < offsets[a + 1]; i += 6)
     {
-      const auto* sol_data = buffer.data() + i * 6;
-      if (isCollisionFree(sol_data))
-      {
-        solution_set.insert(end(solution_set), sol_data, sol_data + 6);
-        solution_set.insert(end(solution_set), angle);
-      }
+      vertices.insert(end(vertices), buffer.data() + i, buffer.data() + i + 6);
+      vertices.push_back(angles[a]);
     }
   }
 
+  if (check)
+    appendCollisionFree(ThreadClones::local(collision_), vertices.data(), 7, vertices.size() / 7, false, solution_set);
+  else
+    solution_set.insert(end(solution_set), vertices.begin(), vertices.end());
+
   return !solution_set.empty();
 }
 
@@ -89,11 +122,29 @@ SpoolSampler<FloatType>::SpoolSampler(const Eigen::Transform<FloatType, 3, Eigen
 template <typename FloatType>
 bool SpoolSampler<FloatType>::isCollisionFree(const FloatType* vertex)
 {
-  return collision_->validate(vertex, 7);
+  return ThreadClones::local(collision_)->validate(vertex, 7);
 }
 
 template <typename FloatType>
 bool SpoolSampler<FloatType>::sample(std::vector<FloatType>& solution_set)
+{
+  return sampleSolutions(solution_set, true);
+}
+
+template <typename FloatType>
+bool SpoolSampler<FloatType>::sampleUnchecked(std::vector<FloatType>& solution_set)
+{
+  return sampleSolutions(solution_set, false);
+}
+
+template <typename FloatType>
+bool SpoolSampler<FloatType>::isValid(const FloatType* vertex)
+{
+  return isCollisionFree(vertex);
+}
+
+template <typename FloatType>
+bool SpoolSampler<FloatType>::sampleSolutions(std::vector<FloatType>& solution_set, const bool check)
 {
   // We need to translate the tool pose to the "robot" frame
   // We need some strategy for moving the positioner around to generate many of these frames
@@ -112,25 +163,40 @@ bool SpoolSampler<FloatType>::sample(std::vector<FloatType>& solution_set)
 
   // So we just loop
   const static FloatType discretization = static_cast<FloatType>(M_PI / 36.0);
+  thread_local std::vector<FloatType> angles;
+  thread_local typename KinematicsInterface<FloatType>::PoseVector poses;
+  angles.clear();
+  poses.clear();
   for (FloatType angle = static_cast<FloatType>(-2.0 * M_PI); angle <= static_cast<FloatType>(2.0 * M_PI);
        angle += discretization)
   {
-    std::vector<FloatType> buffer;
-    kin_->ik(to_robot_frame(tool_pose_, angle), buffer);
+    angles.push_back(angle);
+    poses.push_back(to_robot_frame(tool_pose_, angle));
+  }
+
+  // Solve every positioner angle in one call
+  thread_local std::vector<FloatType> buffer;
+  thread_local std::vector<std::size_t> offsets;
+  buffer.clear();
+  ThreadClones::local(kin_)->ik(poses.data(), poses.size(), buffer, offsets);
 
-    // Now test the solutions
-    const auto n_sols = buffer.size() / 6;
-    for (std::size_t i = 0; i < n_sols; ++i)
+  // Append the positioner angle to each solution, then test them all in one batch
+  thread_local std::vector<FloatType> vertices;
+  vertices.clear();
+  for (std::size_t a = 0; a < angles.size(); ++a)
+  {
+    for (std::size_t i = offsets[a]; i < offsets[a + 1]; i += 6)
     {
-      const auto* sol_data = buffer.data() + i * 6;
-      if (SpoolSampler<FloatType>::isCollisionFree(sol_data))
-      {
-        solution_set.insert(end(solution_set), sol_data, sol_data + 6);
-        solution_set.insert(end(solution_set), angle);
-      }
+      vertices.insert(end(vertices), buffer.data() + i, buffer.data() + i + 6);
+      vertices.push_back(angles[a]);
     }
   }
 
+  if (check)
+    appendCollisionFree(ThreadClones::local(collision_), vertices.data(), 7, vertices.size() / 7, false, solution_set);
+  else
+    solution_set.insert(end(solution_set), vertices.begin(), vertices.end());
+
   return !solution_set.empty();
 }
 
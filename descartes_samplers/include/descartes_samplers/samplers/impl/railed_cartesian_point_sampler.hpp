@@ -20,8 +20,6 @@
 
 #include "descartes_samplers/samplers/railed_cartesian_point_sampler.h"
 
-const static std::size_t dof = 8;
-
 namespace descartes_light
 {
 template <typename FloatType>
@@ -37,59 +35,41 @@ RailedCartesianPointSampler<FloatType>::RailedCartesianPointSampler(
 template <typename FloatType>
 bool RailedCartesianPointSampler<FloatType>::sample(std::vector<FloatType>& solution_set)
 {
-  std::vector<FloatType> buffer;
-  kin_->ik(tool_pose_, buffer);
-
-  const auto nSamplesInBuffer = [](const std::vector<FloatType>& v) -> std::size_t { return v.size() / dof; };
-
-  const auto n_sols = nSamplesInBuffer(buffer);
-
-  for (std::size_t i = 0; i < n_sols; ++i)
-  {
-    const auto* sol_data = buffer.data() + i * dof;
-    if (isCollisionFree(sol_data))
-      solution_set.insert(end(solution_set), sol_data, sol_data + dof);
-  }
+  thread_local std::vector<FloatType> buffer;
+  buffer.clear();
+  ThreadClones::local(kin_)->ik(tool_pose_, buffer);
+
+  // Check every solution in one batch, falling back to the least colliding one if collisions are allowed
+  appendCollisionFree(ThreadClones::local(collision_),
+                      buffer.data(),
+                      dof,
+                      buffer.size() / dof,
+                      allow_collision_,
+                      solution_set);
+  return !solution_set.empty();
+}
 
-  if (solution_set.empty() && allow_collision_)
-    getBestSolution(solution_set);
+template <typename FloatType>
+bool RailedCartesianPointSampler<FloatType>::sampleUnchecked(std::vector<FloatType>& solution_set)
+{
+  // Falling back to the least colliding solution needs every solution checked
+  if (allow_collision_ || collision_ == nullptr)
+    return sample(solution_set);
 
+  ThreadClones::local(kin_)->ik(tool_pose_, solution_set);
   return !solution_set.empty();
 }
 
 template <typename FloatType>
-bool RailedCartesianPointSampler<FloatType>::isCollisionFree(const FloatType* vertex)
+bool RailedCartesianPointSampler<FloatType>::isValid(const FloatType* vertex)
 {
-  if (collision_ == nullptr)
-    return true;
-  else
-    return collision_->validate(vertex, dof);
+  return allow_collision_ || isCollisionFree(vertex);
 }
 
 template <typename FloatType>
-bool RailedCartesianPointSampler<FloatType>::getBestSolution(std::vector<FloatType>& solution_set)
+bool RailedCartesianPointSampler<FloatType>::isCollisionFree(const FloatType* vertex)
 {
-  FloatType distance = -std::numeric_limits<FloatType>::max();
-  std::vector<FloatType> buffer;
-  kin_->ik(tool_pose_, buffer);
-
-  const auto nSamplesInBuffer = [](const std::vector<FloatType>& v) -> std::size_t { return v.size() / dof; };
-
-  const auto n_sols = nSamplesInBuffer(buffer);
-
-  for (std::size_t i = 0; i < n_sols; ++i)
-  {
-    const auto* sol_data = buffer.data() + i * dof;
-    FloatType cur_distance = collision_->distance(sol_data, dof);
-    if (cur_distance > distance)
-    {
-      distance = cur_distance;
-      solution_set.clear();
-      solution_set.insert(end(solution_set), sol_data, sol_data + dof);
-    }
-  }
-
-  return !solution_set.empty();
+  return collision_ == nullptr || ThreadClones::local(collision_)->validate(vertex, dof);
 }
 
 }  // namespace descartes_light
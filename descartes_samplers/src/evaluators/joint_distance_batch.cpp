@@ -0,0 +1,141 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2016, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#define DESCARTES_JOINT_DISTANCE_ISA sse2
+#include "descartes_samplers/evaluators/impl/joint_distance_batch_kernel.hpp"
+
+namespace descartes_light
+{
+namespace joint_distance
+{
+// Defined in the translation units built for the wider instruction sets
+#ifdef DESCARTES_JOINT_DISTANCE_AVX2
+namespace avx2
+{
+template <typename FloatType>
+void costs(const FloatType* start,
+           const FloatType* ends,
+           const std::size_t stride,
+           const std::size_t n_end,
+           const std::size_t dof,
+           const std::size_t first_joint,
+           const FloatType* delta_thresholds,
+           FloatType* costs);
+}  // namespace avx2
+#endif
+
+#ifdef DESCARTES_JOINT_DISTANCE_AVX512
+namespace avx512
+{
+template <typename FloatType>
+void costs(const FloatType* start,
+           const FloatType* ends,
+           const std::size_t stride,
+           const std::size_t n_end,
+           const std::size_t dof,
+           const std::size_t first_joint,
+           const FloatType* delta_thresholds,
+           FloatType* costs);
+}  // namespace avx512
+#endif
+
+enum class InstructionSet
+{
+  SSE2,
+  AVX2,
+  AVX512
+};
+
+static InstructionSet detectInstructionSet()
+{
+#ifdef DESCARTES_JOINT_DISTANCE_AVX512
+  if (__builtin_cpu_supports("avx512f"))
+    return InstructionSet::AVX512;
+#endif
+#ifdef DESCARTES_JOINT_DISTANCE_AVX2
+  if (__builtin_cpu_supports("avx2"))
+    return InstructionSet::AVX2;
+#endif
+  return InstructionSet::SSE2;
+}
+
+static InstructionSet instructionSet()
+{
+  static const InstructionSet isa = detectInstructionSet();
+  return isa;
+}
+}  // namespace joint_distance
+
+template <typename FloatType>
+void jointDistanceCosts(const FloatType* start,
+                        const FloatType* ends,
+                        std::size_t stride,
+                        std::size_t n_end,
+                        std::size_t dof,
+                        std::size_t first_joint,
+                        const FloatType* delta_thresholds,
+                        FloatType* costs)
+{
+  switch (joint_distance::instructionSet())
+  {
+#ifdef DESCARTES_JOINT_DISTANCE_AVX512
+    case joint_distance::InstructionSet::AVX512:
+      joint_distance::avx512::costs(start, ends, stride, n_end, dof, first_joint, delta_thresholds, costs);
+      return;
+#endif
+#ifdef DESCARTES_JOINT_DISTANCE_AVX2
+    case joint_distance::InstructionSet::AVX2:
+      joint_distance::avx2::costs(start, ends, stride, n_end, dof, first_joint, delta_thresholds, costs);
+      return;
+#endif
+    default:
+      joint_distance::sse2::costs(start, ends, stride, n_end, dof, first_joint, delta_thresholds, costs);
+  }
+}
+
+const char* jointDistanceInstructionSet()
+{
+  switch (joint_distance::instructionSet())
+  {
+    case joint_distance::InstructionSet::AVX512:
+      return "avx512";
+    case joint_distance::InstructionSet::AVX2:
+      return "avx2";
+    default:
+      return "sse2";
+  }
+}
+
+// Explicit template instantiation
+template DESCARTES_PUBLIC void jointDistanceCosts<float>(const float* start,
+                                                         const float* ends,
+                                                         std::size_t stride,
+                                                         std::size_t n_end,
+                                                         std::size_t dof,
+                                                         std::size_t first_joint,
+                                                         const float* delta_thresholds,
+                                                         float* costs);
+template DESCARTES_PUBLIC void jointDistanceCosts<double>(const double* start,
+                                                          const double* ends,
+                                                          std::size_t stride,
+                                                          std::size_t n_end,
+                                                          std::size_t dof,
+                                                          std::size_t first_joint,
+                                                          const double* delta_thresholds,
+                                                          double* costs);
+
+}  // namespace descartes_light
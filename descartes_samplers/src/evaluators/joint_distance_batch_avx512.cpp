@@ -0,0 +1,47 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2016, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+// Built with AVX512 enabled; only called after jointDistanceCosts() has checked that the CPU supports it
+#define DESCARTES_JOINT_DISTANCE_ISA avx512
+#include "descartes_samplers/evaluators/impl/joint_distance_batch_kernel.hpp"
+
+namespace descartes_light
+{
+namespace joint_distance
+{
+namespace avx512
+{
+// Explicit template instantiation
+template void costs<float>(const float* start,
+                           const float* ends,
+                           const std::size_t stride,
+                           const std::size_t n_end,
+                           const std::size_t dof,
+                           const std::size_t first_joint,
+                           const float* delta_thresholds,
+                           float* costs);
+template void costs<double>(const double* start,
+                            const double* ends,
+                            const std::size_t stride,
+                            const std::size_t n_end,
+                            const std::size_t dof,
+                            const std::size_t first_joint,
+                            const double* delta_thresholds,
+                            double* costs);
+}  // namespace avx512
+}  // namespace joint_distance
+}  // namespace descartes_light
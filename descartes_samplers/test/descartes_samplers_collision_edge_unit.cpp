@@ -0,0 +1,232 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2016, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <descartes_light/descartes_light.h>
+#include <descartes_samplers/evaluators/collision_edge_evaluator.h>
+#include <descartes_samplers/evaluators/euclidean_distance_edge_evaluator.h>
+
+using namespace descartes_light;
+
+// Checks that the eager and lazy modes of CollisionEdgeEvaluator remove the same edges from the paths of the solver
+
+namespace
+{
+const std::size_t DOF = 2;
+
+/** @brief A waypoint with fixed vertices, all free of collision */
+class FixedSampler : public PositionSamplerD
+{
+public:
+  explicit FixedSampler(std::vector<double> vertices) : vertices_(std::move(vertices)) {}
+
+  bool sample(std::vector<double>& solution_set) override
+  {
+    solution_set.insert(solution_set.end(), vertices_.begin(), vertices_.end());
+    return !vertices_.empty();
+  }
+
+private:
+  std::vector<double> vertices_;
+};
+
+/** @brief A spherical obstacle in joint space; records every state it checks */
+class BallCollision : public CollisionInterfaceD
+{
+public:
+  BallCollision(std::vector<double> center, double radius) : center_(std::move(center)), radius_(radius) {}
+
+  bool validate(const double* pos, const std::size_t size) override
+  {
+    checked_.emplace_back(pos, pos + size);
+    return distance(pos, size) >= 0;
+  }
+
+  double distance(const double* pos, const std::size_t size) override
+  {
+    double d = 0;
+    for (std::size_t j = 0; j < size; ++j)
+      d += (pos[j] - center_[j]) * (pos[j] - center_[j]);
+    return std::sqrt(d) - radius_;
+  }
+
+  CollisionInterfaceD::Ptr clone() const override { return nullptr; }
+
+  const std::vector<std::vector<double>>& checked() const { return checked_; }
+
+  void clear() { checked_.clear(); }
+
+private:
+  std::vector<double> center_;
+  double radius_;
+  std::vector<std::vector<double>> checked_;
+};
+
+std::vector<PositionSamplerD::Ptr> makeTrajectory(const std::size_t n_rungs, const std::size_t n_vertices)
+{
+  std::mt19937 rng(17);
+  std::uniform_real_distribution<double> value(-1.0, 1.0);
+
+  std::vector<PositionSamplerD::Ptr> trajectory;
+  for (std::size_t r = 0; r < n_rungs; ++r)
+  {
+    std::vector<double> vertices(n_vertices * DOF);
+    for (auto& v : vertices)
+      v = value(rng);
+    trajectory.push_back(std::make_shared<FixedSampler>(std::move(vertices)));
+  }
+  return trajectory;
+}
+
+/** @brief The midpoint of the motion from vertex 'from' to vertex 'to' of a path */
+std::vector<double> midpoint(const std::vector<double>& path, const std::size_t from, const std::size_t to)
+{
+  std::vector<double> m(DOF);
+  for (std::size_t j = 0; j < DOF; ++j)
+    m[j] = 0.5 * (path[from * DOF + j] + path[to * DOF + j]);
+  return m;
+}
+
+/** @brief An obstacle on the motion between two vertices of a path, clear of every vertex of the trajectory */
+std::shared_ptr<BallCollision> makeObstacle(const std::vector<PositionSamplerD::Ptr>& trajectory,
+                                            const std::vector<double>& path,
+                                            const std::size_t from,
+                                            const std::size_t to)
+{
+  auto obstacle = std::make_shared<BallCollision>(midpoint(path, from, to), 0.05);
+  for (const auto& sampler : trajectory)
+  {
+    std::vector<double> vertices;
+    sampler->sample(vertices);
+    for (std::size_t i = 0; i < vertices.size(); i += DOF)
+      EXPECT_TRUE(obstacle->validate(vertices.data() + i, DOF));
+  }
+  obstacle->clear();
+  return obstacle;
+}
+
+/** @brief Builds and searches the trajectory, with 'collision' checked along the edges if given */
+bool solve(const std::vector<PositionSamplerD::Ptr>& trajectory,
+           const std::shared_ptr<BallCollision>& collision,
+           const bool lazy,
+           const bool cyclic,
+           std::vector<double>& solution,
+           const bool lazy_edges = false)
+{
+  EdgeEvaluatorD::Ptr edge_eval = std::make_shared<EuclideanDistanceEdgeEvaluatorD>(static_cast<int>(DOF));
+  if (collision)
+    edge_eval = std::make_shared<CollisionEdgeEvaluatorD>(static_cast<int>(DOF), edge_eval, collision, 0.05, lazy);
+
+  SolverD solver(DOF);
+  solver.setLazyEdges(lazy_edges);
+  const std::vector<descartes_core::TimingConstraintD> times(trajectory.size());
+  if (!solver.build(trajectory, times, edge_eval, 1))
+    return false;
+
+  return cyclic ? solver.searchCyclic(solution) : solver.search(solution);
+}
+}  // namespace
+
+TEST(DescartesSamplersCollisionEdgeUnit, MidpointFirst)
+{
+  const std::vector<double> from = { 0.0, 0.0 };
+  const std::vector<double> to = { 0.8, -0.4 };
+  auto far = std::make_shared<BallCollision>(std::vector<double>{ 5.0, 5.0 }, 0.1);
+  CollisionEdgeEvaluatorD evaluator(
+      static_cast<int>(DOF), std::make_shared<EuclideanDistanceEdgeEvaluatorD>(static_cast<int>(DOF)), far, 0.1);
+
+  // 8 segments: the midpoint, then the quarter points, then the rest; the vertices are not checked
+  EXPECT_TRUE(evaluator.isValid(from.data(), to.data(), DOF));
+  const std::vector<std::size_t> order = { 4, 2, 6, 1, 3, 5, 7 };
+  ASSERT_EQ(far->checked().size(), order.size());
+  for (std::size_t k = 0; k < order.size(); ++k)
+  {
+    EXPECT_NEAR(far->checked()[k][0], 0.1 * static_cast<double>(order[k]), 1e-12);
+    EXPECT_NEAR(far->checked()[k][1], -0.05 * static_cast<double>(order[k]), 1e-12);
+  }
+
+  // A motion through an obstacle at its midpoint fails on the first check
+  auto middle = std::make_shared<BallCollision>(std::vector<double>{ 0.4, -0.2 }, 0.01);
+  CollisionEdgeEvaluatorD blocked(
+      static_cast<int>(DOF), std::make_shared<EuclideanDistanceEdgeEvaluatorD>(static_cast<int>(DOF)), middle, 0.1);
+  EXPECT_FALSE(blocked.isValid(from.data(), to.data(), DOF));
+  EXPECT_EQ(middle->checked().size(), 1u);
+}
+
+TEST(DescartesSamplersCollisionEdgeUnit, LazyMatchesEager)
+{
+  const auto trajectory = makeTrajectory(6, 5);
+
+  // Block the middle edge of the best path without collision checking
+  std::vector<double> best;
+  ASSERT_TRUE(solve(trajectory, nullptr, false, false, best));
+  const auto obstacle = makeObstacle(trajectory, best, 2, 3);
+
+  std::vector<double> eager;
+  ASSERT_TRUE(solve(trajectory, obstacle, false, false, eager));
+  EXPECT_NE(eager, best);
+
+  for (const bool lazy_edges : { false, true })
+  {
+    obstacle->clear();
+    std::vector<double> lazy;
+    ASSERT_TRUE(solve(trajectory, obstacle, true, false, lazy, lazy_edges));
+    EXPECT_EQ(eager, lazy);
+
+    // The first search returns the best path, whose blocked edge is the only one to fail
+    std::size_t n_failed = 0;
+    for (const auto& state : obstacle->checked())
+      n_failed += obstacle->distance(state.data(), DOF) < 0 ? 1u : 0u;
+    EXPECT_EQ(n_failed, 1u);
+  }
+}
+
+TEST(DescartesSamplersCollisionEdgeUnit, ClosingEdgeRemoved)
+{
+  const auto trajectory = makeTrajectory(5, 4);
+
+  // Block the closing motion of the best cycle, from its last vertex back to its first
+  std::vector<double> best;
+  ASSERT_TRUE(solve(trajectory, nullptr, false, true, best));
+  const auto obstacle = makeObstacle(trajectory, best, trajectory.size() - 1, 0);
+
+  std::vector<double> eager;
+  ASSERT_TRUE(solve(trajectory, obstacle, false, true, eager));
+  EXPECT_NE(eager, best);
+
+  std::vector<double> lazy;
+  ASSERT_TRUE(solve(trajectory, obstacle, true, true, lazy, true));
+  EXPECT_EQ(eager, lazy);
+
+  // The closing motion of the cycle found is free of collision
+  CollisionEdgeEvaluatorD checker(
+      static_cast<int>(DOF), std::make_shared<EuclideanDistanceEdgeEvaluatorD>(static_cast<int>(DOF)), obstacle, 0.05);
+  EXPECT_TRUE(checker.isValid(lazy.data() + (trajectory.size() - 1) * DOF, lazy.data(), DOF));
+  EXPECT_FALSE(checker.isValid(best.data() + (trajectory.size() - 1) * DOF, best.data(), DOF));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}